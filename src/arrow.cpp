@@ -0,0 +1,562 @@
+# include "flexplot.h"
+# include <cstring>
+
+// Arrow IPC file (Feather version 2) reading
+
+namespace Graphs {
+    namespace {
+        const char MAGIC[] = "ARROW1";
+        const size_t MAGIC_SIZE = 6;
+
+        // Type union tags from Schema.fbs
+        const int TYPE_INT = 2;
+        const int TYPE_FLOAT = 3;
+        const int TYPE_UTF8 = 5;
+        const int TYPE_UNION = 14;
+        const int TYPE_LARGE_UTF8 = 20;
+        const int TYPE_LAST_SUPPORTED = 21; /*< Later types have variadic buffers */
+
+        // MessageHeader union tags from Message.fbs
+        const int HEADER_DICTIONARY_BATCH = 2;
+        const int HEADER_RECORD_BATCH = 3;
+
+        inline std::runtime_error malformed() {
+            return std::runtime_error("Malformed Arrow file");
+        }
+
+        /** Bounds-checked, unaligned reads from a flatbuffer */
+        struct FlatBuffer {
+            const uint8_t* data = nullptr;
+            size_t size = 0;
+
+            template<typename T>
+            inline T read(size_t pos) const {
+                if (pos > size || size - pos < sizeof(T)) throw malformed();
+                T value;
+                memcpy(&value, data + pos, sizeof(T));
+                return value;
+            }
+        };
+
+        /** A table inside a flatbuffer, located through its vtable */
+        class FlatTable {
+        public:
+            FlatTable() {};
+            FlatTable(const FlatBuffer& _buf, size_t _pos) : buf(_buf), pos(_pos) {
+                int64_t vtable_pos = (int64_t)pos - buf.read<int32_t>(pos);
+                if (vtable_pos < 0) throw malformed();
+                this->vtable = (size_t)vtable_pos;
+                this->vtable_size = buf.read<uint16_t>(vtable);
+                this->valid = true;
+            }
+
+            inline explicit operator bool() const { return valid; }
+
+            template<typename T>
+            inline T get(int field, T fallback = T()) const {
+                size_t off = this->offset(field);
+                return off ? buf.read<T>(pos + off) : fallback;
+            }
+
+            inline FlatTable table(int field) const {
+                size_t target = this->indirect(field);
+                return target ? FlatTable(buf, target) : FlatTable();
+            }
+
+            inline std::string string(int field) const {
+                size_t target = this->indirect(field);
+                if (!target) return "";
+
+                size_t length = buf.read<uint32_t>(target);
+                if (length > buf.size - target - 4) throw malformed();
+                return std::string((const char*)buf.data + target + 4, length);
+            }
+
+            inline size_t vector(int field, size_t& elements) const {
+                /** Return the length of a vector and set elements to its first element */
+                size_t target = this->indirect(field);
+                if (!target) return 0;
+
+                elements = target + 4;
+                return buf.read<uint32_t>(target);
+            }
+
+            inline FlatTable table_at(size_t elements, size_t i) const {
+                /** The i-th table in a vector of tables */
+                size_t entry = elements + 4 * i;
+                return FlatTable(buf, entry + buf.read<uint32_t>(entry));
+            }
+
+            template<typename T>
+            inline T struct_field(size_t elements, size_t i, size_t struct_size, size_t offset) const {
+                /** A field of the i-th struct in a vector of structs */
+                return buf.read<T>(elements + i * struct_size + offset);
+            }
+
+        private:
+            inline size_t offset(int field) const {
+                size_t entry = 4 + 2 * (size_t)field;
+                if (!valid || entry + 2 > vtable_size) return 0;
+                return buf.read<uint16_t>(vtable + entry);
+            }
+
+            inline size_t indirect(int field) const {
+                size_t off = this->offset(field);
+                if (!off) return 0;
+                return pos + off + buf.read<uint32_t>(pos + off);
+            }
+
+            FlatBuffer buf;
+            size_t pos = 0;
+            size_t vtable = 0;
+            size_t vtable_size = 0;
+            bool valid = false;
+        };
+
+        /** Location of an encapsulated message in the file (Block in File.fbs) */
+        struct Block {
+            int64_t offset;
+            int32_t metadata_length;
+            int64_t body_length;
+        };
+
+        std::vector<Block> read_blocks(const FlatTable& footer, int field) {
+            std::vector<Block> ret;
+            size_t elements = 0, n = footer.vector(field, elements);
+            for (size_t i = 0; i < n; i++) {
+                ret.push_back({
+                    footer.struct_field<int64_t>(elements, i, 24, 0),
+                    footer.struct_field<int32_t>(elements, i, 24, 8),
+                    footer.struct_field<int64_t>(elements, i, 24, 16)
+                });
+            }
+
+            return ret;
+        }
+
+        void count_buffers(const FlatTable& field, size_t& nodes, size_t& buffers) {
+            /** Count the field nodes and buffers a field and its children
+             *  take up in a record batch
+             */
+            const int type = field.get<uint8_t>(2);
+            if (type == TYPE_UNION || type > TYPE_LAST_SUPPORTED)
+                throw std::runtime_error("Unsupported Arrow type in " + field.string(0));
+
+            nodes++;
+            if (field.table(4)) { // Dictionary indices
+                buffers += 2;
+                return;
+            }
+
+            switch (type) {
+            case 1: break;                  // Null
+            case 4: case 5: case 19: case 20: // Binary and strings: validity, offsets, data
+                buffers += 3;
+                break;
+            case 13: case 16:               // Struct and fixed size list: validity
+                buffers += 1;
+                break;
+            default:                        // Validity and values or offsets
+                buffers += 2;
+            }
+
+            size_t elements = 0, n = field.vector(5, elements);
+            for (size_t i = 0; i < n; i++)
+                count_buffers(field.table_at(elements, i), nodes, buffers);
+        }
+
+        inline int64_t read_int(const uint8_t* values, size_t i, int bit_width, bool is_signed) {
+            switch (bit_width) {
+            case 8: return is_signed ? (int64_t)((const int8_t*)values)[i] : (int64_t)values[i];
+            case 16: {
+                uint16_t value;
+                memcpy(&value, values + 2 * i, 2);
+                return is_signed ? (int64_t)(int16_t)value : (int64_t)value;
+            }
+            case 32: {
+                uint32_t value;
+                memcpy(&value, values + 4 * i, 4);
+                return is_signed ? (int64_t)(int32_t)value : (int64_t)value;
+            }
+            default: {
+                int64_t value;
+                memcpy(&value, values + 8 * i, 8);
+                return value;
+            }
+            }
+        }
+
+        inline std::string read_string(const ArrowReader::Chunk& chunk, size_t i, bool large) {
+            int64_t begin, end;
+            if (large) {
+                memcpy(&begin, chunk.offsets + 8 * i, 8);
+                memcpy(&end, chunk.offsets + 8 * (i + 1), 8);
+            }
+            else {
+                int32_t offsets[2];
+                memcpy(offsets, chunk.offsets + 4 * i, 8);
+                begin = offsets[0];
+                end = offsets[1];
+            }
+
+            if (end == begin) return "";
+            return std::string((const char*)chunk.values + begin, (size_t)(end - begin));
+        }
+    }
+
+    ArrowReader::ArrowReader(const std::string& filename) : file(filename) {
+        const uint8_t* data = (const uint8_t*)this->file.data();
+        const size_t size = this->file.size();
+        FlatBuffer whole = { data, size };
+
+        if (size < 2 * MAGIC_SIZE + 6 || memcmp(data, MAGIC, MAGIC_SIZE) != 0
+            || memcmp(data + size - MAGIC_SIZE, MAGIC, MAGIC_SIZE) != 0)
+            throw std::runtime_error(filename + " isn't an Arrow IPC file");
+
+        // File ends with the footer, its length and the magic string
+        size_t footer_length = whole.read<uint32_t>(size - MAGIC_SIZE - 4);
+        if (footer_length > size - 2 * MAGIC_SIZE - 6)
+            throw malformed();
+
+        FlatBuffer footer_buf = { data + size - MAGIC_SIZE - 4 - footer_length, footer_length };
+        FlatTable footer(footer_buf, footer_buf.read<uint32_t>(0));
+        FlatTable schema = footer.table(1);
+        if (!schema)
+            throw malformed();
+        if (schema.get<int16_t>(0) != 0)
+            throw std::runtime_error("Big-endian Arrow files aren't supported");
+
+        // Describe each top-level column and where its buffers are
+        std::vector<size_t> first_node, first_buffer;
+        size_t nodes = 0, buffers = 0;
+        size_t elements = 0, n = schema.vector(1, elements);
+
+        for (size_t i = 0; i < n; i++) {
+            FlatTable field_table = schema.table_at(elements, i);
+            Field info;
+            info.name = field_table.string(0);
+
+            FlatTable type = field_table.table(3);
+            switch (field_table.get<uint8_t>(2)) {
+            case TYPE_INT:
+                info.type = Type::INT;
+                info.bit_width = type.get<int32_t>(0);
+                info.is_signed = type.get<uint8_t>(1) != 0;
+                break;
+            case TYPE_FLOAT: {
+                int16_t precision = type.get<int16_t>(0); // HALF, SINGLE, DOUBLE
+                if (precision >= 0 && precision <= 2) {
+                    info.type = Type::FLOAT;
+                    info.bit_width = 16 << precision;
+                }
+                break;
+            }
+            case TYPE_UTF8:
+                info.type = Type::UTF8;
+                break;
+            case TYPE_LARGE_UTF8:
+                info.type = Type::LARGE_UTF8;
+                break;
+            }
+
+            FlatTable encoding = field_table.table(4);
+            if (encoding) {
+                FlatTable index_type = encoding.table(1);
+                info.dictionary = true;
+                info.dictionary_id = encoding.get<int64_t>(0);
+                info.bit_width = index_type ? index_type.get<int32_t>(0) : 32;
+                info.is_signed = index_type ? index_type.get<uint8_t>(1) != 0 : true;
+            }
+
+            if (info.type == Type::INT || info.dictionary) {
+                if (info.bit_width != 8 && info.bit_width != 16 && info.bit_width != 32 && info.bit_width != 64)
+                    throw malformed();
+            }
+
+            first_node.push_back(nodes);
+            first_buffer.push_back(buffers);
+            count_buffers(field_table, nodes, buffers);
+
+            this->names.push_back(info.name);
+            this->fields.push_back(std::move(info));
+        }
+
+        /** Read the message at a block and return its header table of the
+         *  given type, setting body to the start of the message's body
+         */
+        auto read_message = [&](const Block& block, int header_type, FlatBuffer& meta,
+            const uint8_t*& body) {
+            if (block.offset < 0 || block.metadata_length < 8 || block.body_length < 0
+                || (uint64_t)block.offset > size
+                || (uint64_t)block.metadata_length + (uint64_t)block.body_length > size - (size_t)block.offset)
+                throw malformed();
+
+            size_t pos = (size_t)block.offset;
+            size_t length = whole.read<uint32_t>(pos);
+            pos += 4;
+            if (length == 0xFFFFFFFF) { // Continuation marker
+                length = whole.read<uint32_t>(pos);
+                pos += 4;
+            }
+
+            if (pos + length > (size_t)block.offset + (size_t)block.metadata_length)
+                throw malformed();
+
+            meta = { data + pos, length };
+            body = data + block.offset + block.metadata_length;
+
+            FlatTable message(meta, meta.read<uint32_t>(0));
+            FlatTable header = message.table(2);
+            if (message.get<uint8_t>(1) != header_type || !header)
+                throw malformed();
+            return header;
+        };
+
+        /** Locate a record batch's buffers, checking they lie inside its body */
+        auto read_batch = [&](const FlatTable& batch, const Block& block, const uint8_t* body,
+            std::vector<std::pair<int64_t, int64_t>>& field_nodes,
+            std::vector<const uint8_t*>& buffer_ptrs, std::vector<int64_t>& buffer_sizes) {
+            if (batch.table(3))
+                throw std::runtime_error("Compressed Arrow files aren't supported");
+
+            size_t elements = 0, n = batch.vector(1, elements);
+            for (size_t i = 0; i < n; i++) {
+                field_nodes.push_back({ batch.struct_field<int64_t>(elements, i, 16, 0),
+                    batch.struct_field<int64_t>(elements, i, 16, 8) });
+                if (field_nodes.back().first < 0 || field_nodes.back().second < 0)
+                    throw malformed();
+            }
+
+            n = batch.vector(2, elements);
+            for (size_t i = 0; i < n; i++) {
+                int64_t offset = batch.struct_field<int64_t>(elements, i, 16, 0),
+                    length = batch.struct_field<int64_t>(elements, i, 16, 8);
+                if (offset < 0 || length < 0 || offset > block.body_length
+                    || length > block.body_length - offset)
+                    throw malformed();
+
+                buffer_ptrs.push_back(length ? body + offset : nullptr);
+                buffer_sizes.push_back(length);
+            }
+        };
+
+        auto make_chunk = [&](const Field& info, size_t length, size_t null_count,
+            const std::vector<const uint8_t*>& ptrs, const std::vector<int64_t>& sizes,
+            size_t buffer) {
+            /** Build a chunk for a column of a supported type from its buffers */
+            Chunk chunk;
+            chunk.length = length;
+            chunk.null_count = null_count;
+            if (null_count > length) throw malformed();
+
+            // Whether a buffer fits count values of a whole number of bytes.
+            // Lengths come from the file, so divide rather than multiply.
+            auto fits = [&sizes](size_t buffer, size_t count, size_t bytes) {
+                return count <= (uint64_t)sizes.at(buffer) / bytes;
+            };
+
+            if (null_count) {
+                if (length / 8 + (length % 8 != 0) > (uint64_t)sizes.at(buffer)) throw malformed();
+                chunk.validity = ptrs[buffer];
+            }
+
+            bool strings = !info.dictionary &&
+                (info.type == Type::UTF8 || info.type == Type::LARGE_UTF8);
+            if (strings) {
+                size_t width = info.type == Type::LARGE_UTF8 ? 8 : 4;
+                if (length && !fits(buffer + 1, length + 1, width)) throw malformed();
+                chunk.offsets = ptrs[buffer + 1];
+                chunk.values = ptrs.at(buffer + 2);
+
+                // Every string has to lie inside the data buffer
+                int64_t previous = 0;
+                for (size_t i = 0; i <= length && length; i++) {
+                    int64_t offset = read_int(chunk.offsets, i, 8 * (int)width, true);
+                    if (offset < previous || offset > sizes[buffer + 2]) throw malformed();
+                    previous = offset;
+                }
+            }
+            else if (info.type == Type::INT || info.type == Type::FLOAT || info.dictionary) {
+                if (!fits(buffer + 1, length, info.bit_width / 8)) throw malformed();
+                chunk.values = ptrs[buffer + 1];
+            }
+
+            return chunk;
+        };
+
+        // Decode string dictionaries
+        for (const Block& block : read_blocks(footer, 2)) {
+            FlatBuffer meta;
+            const uint8_t* body;
+            FlatTable dictionary = read_message(block, HEADER_DICTIONARY_BATCH, meta, body);
+            const int64_t id = dictionary.get<int64_t>(0);
+
+            auto owner = std::find_if(this->fields.begin(), this->fields.end(),
+                [id](const Field& info) { return info.dictionary && info.dictionary_id == id; });
+            if (owner == this->fields.end() ||
+                (owner->type != Type::UTF8 && owner->type != Type::LARGE_UTF8))
+                continue; // Only string dictionaries are decoded
+
+            std::vector<std::pair<int64_t, int64_t>> field_nodes;
+            std::vector<const uint8_t*> ptrs;
+            std::vector<int64_t> sizes;
+            read_batch(dictionary.table(1), block, body, field_nodes, ptrs, sizes);
+            if (field_nodes.empty() || ptrs.size() < 3)
+                throw malformed();
+
+            Field values = *owner;
+            values.dictionary = false;
+            Chunk chunk = make_chunk(values, (size_t)field_nodes[0].first,
+                (size_t)field_nodes[0].second, ptrs, sizes, 0);
+
+            auto& entries = this->dictionaries[id];
+            if (!dictionary.get<uint8_t>(2)) // Not a delta
+                entries.clear();
+            for (size_t i = 0; i < chunk.length; i++)
+                entries.push_back(chunk.is_null(i) ? "" :
+                    read_string(chunk, i, values.type == Type::LARGE_UTF8));
+        }
+
+        // Locate every column's buffers in every record batch
+        for (const Block& block : read_blocks(footer, 3)) {
+            FlatBuffer meta;
+            const uint8_t* body;
+            FlatTable batch = read_message(block, HEADER_RECORD_BATCH, meta, body);
+
+            std::vector<std::pair<int64_t, int64_t>> field_nodes;
+            std::vector<const uint8_t*> ptrs;
+            std::vector<int64_t> sizes;
+            read_batch(batch, block, body, field_nodes, ptrs, sizes);
+            if (field_nodes.size() != nodes || ptrs.size() != buffers)
+                throw malformed();
+
+            const size_t length = (size_t)batch.get<int64_t>(0);
+            for (size_t i = 0; i < this->fields.size(); i++) {
+                const auto& node = field_nodes[first_node[i]];
+                if ((size_t)node.first != length)
+                    throw malformed();
+
+                this->fields[i].chunks.push_back(make_chunk(this->fields[i], length,
+                    (size_t)node.second, ptrs, sizes, first_buffer[i]));
+            }
+
+            this->batch_rows.push_back(length);
+            this->rows += length;
+        }
+    }
+
+    const ArrowReader::Field& ArrowReader::field(const std::string& name) const {
+        for (auto& info : this->fields)
+            if (info.name == name) return info;
+        throw ColumnNotFoundError(name);
+    }
+
+    template<typename V>
+    void ArrowReader::convert(const Field& info, const Chunk& chunk, V* out) {
+        /** Convert one chunk of a numeric column, turning nulls into NAN */
+        for (size_t i = 0; i < chunk.length; i++) {
+            if (chunk.is_null(i))
+                out[i] = (V)NAN;
+            else if (info.type == Type::INT)
+                out[i] = info.is_signed || info.bit_width < 64 ?
+                    (V)read_int(chunk.values, i, info.bit_width, info.is_signed) :
+                    (V)(uint64_t)read_int(chunk.values, i, 64, false);
+            else if (info.bit_width == 64) {
+                double value;
+                memcpy(&value, chunk.values + 8 * i, 8);
+                out[i] = (V)value;
+            }
+            else {
+                float value;
+                memcpy(&value, chunk.values + 4 * i, 4);
+                out[i] = (V)value;
+            }
+        }
+    }
+
+    namespace {
+        void check_numeric(const ArrowReader::Field& info) {
+            if (info.dictionary || !(info.type == ArrowReader::Type::INT ||
+                (info.type == ArrowReader::Type::FLOAT && info.bit_width != 16)))
+                throw std::runtime_error("Column " + info.name + " isn't numeric");
+        }
+    }
+
+    template<typename V>
+    std::vector<V> ArrowReader::numeric_column(const std::string& name) const {
+        /** Copy and convert a numeric column from every record batch,
+         *  turning nulls into NAN
+         */
+        const Field& info = this->field(name);
+        check_numeric(info);
+
+        std::vector<V> ret(this->rows);
+        std::vector<size_t> starts;
+        size_t start = 0;
+        for (auto& chunk : info.chunks) {
+            starts.push_back(start);
+            start += chunk.length;
+        }
+
+        parallel_tasks(info.chunks.size(), parallel_chunks(this->rows, 1 << 20), [&](size_t c) {
+            convert(info, info.chunks[c], ret.data() + starts[c]);
+        });
+
+        return ret;
+    }
+
+    template<typename V>
+    std::vector<V> ArrowReader::numeric_column(const std::string& name, size_t batch) const {
+        /** Copy and convert a numeric column from one record batch */
+        const Field& info = this->field(name);
+        check_numeric(info);
+
+        const Chunk& chunk = info.chunks.at(batch);
+        std::vector<V> ret(chunk.length);
+        convert(info, chunk, ret.data());
+        return ret;
+    }
+
+    template std::vector<float> ArrowReader::numeric_column(const std::string&) const;
+    template std::vector<double> ArrowReader::numeric_column(const std::string&) const;
+    template std::vector<long double> ArrowReader::numeric_column(const std::string&) const;
+    template std::vector<float> ArrowReader::numeric_column(const std::string&, size_t) const;
+    template std::vector<double> ArrowReader::numeric_column(const std::string&, size_t) const;
+    template std::vector<long double> ArrowReader::numeric_column(const std::string&, size_t) const;
+
+    std::vector<std::string> ArrowReader::text_column(const std::string& name) const {
+        /** Copy a string or dictionary-encoded string column, turning nulls
+         *  into empty strings. Each dictionary is decoded once up front.
+         */
+        const Field& info = this->field(name);
+        if (info.type != Type::UTF8 && info.type != Type::LARGE_UTF8)
+            throw std::runtime_error("Column " + name + " doesn't hold strings");
+
+        const std::vector<std::string>* dictionary = nullptr;
+        if (info.dictionary) {
+            auto it = this->dictionaries.find(info.dictionary_id);
+            if (it == this->dictionaries.end())
+                throw malformed();
+            dictionary = &it->second;
+        }
+
+        std::vector<std::string> ret;
+        ret.reserve(this->rows);
+        for (auto& chunk : info.chunks) {
+            for (size_t i = 0; i < chunk.length; i++) {
+                if (chunk.is_null(i))
+                    ret.emplace_back();
+                else if (dictionary) {
+                    int64_t index = read_int(chunk.values, i, info.bit_width, info.is_signed);
+                    if (index < 0 || (size_t)index >= dictionary->size())
+                        throw malformed();
+                    ret.push_back((*dictionary)[(size_t)index]);
+                }
+                else
+                    ret.push_back(read_string(chunk, i, info.type == Type::LARGE_UTF8));
+            }
+        }
+
+        return ret;
+    }
+}
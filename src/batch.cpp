@@ -0,0 +1,86 @@
+# include "flexplot.h"
+
+// Concurrent rendering of many independent plots
+
+namespace Graphs {
+    BatchRenderer::BatchRenderer(size_t threads, size_t _max_pending) {
+        if (!threads)
+            threads = std::max((size_t)std::thread::hardware_concurrency(), (size_t)1);
+        this->max_pending = _max_pending ? _max_pending : 2 * threads;
+
+        for (size_t i = 0; i < threads; i++)
+            this->workers.emplace_back(&BatchRenderer::work, this);
+    }
+
+    BatchRenderer::~BatchRenderer() {
+        this->finish();
+    }
+
+    void BatchRenderer::enqueue(std::function<void()> job) {
+        std::unique_lock<std::mutex> guard(this->lock);
+        this->has_room.wait(guard, [this]() {
+            return this->stopping || this->pending.size() < this->max_pending;
+        });
+
+        if (this->stopping)
+            throw std::runtime_error("Can't submit jobs after finish() has been called.");
+
+        this->pending.emplace_back(this->stats.jobs++, std::move(job));
+        this->stats.latency.push_back(NAN);
+        this->has_job.notify_one();
+    }
+
+    void BatchRenderer::work() {
+        std::unique_lock<std::mutex> guard(this->lock);
+        while (true) {
+            this->has_job.wait(guard, [this]() {
+                return this->stopping || !this->pending.empty();
+            });
+
+            if (this->pending.empty())
+                return;
+
+            auto job = std::move(this->pending.front());
+            this->pending.pop_front();
+            this->has_room.notify_one();
+            guard.unlock();
+
+            auto begin = std::chrono::steady_clock::now();
+            bool ok = true;
+            try {
+                job.second();
+            }
+            catch (...) {
+                ok = false;
+            }
+
+            std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - begin;
+            guard.lock();
+            if (ok)
+                this->stats.latency[job.first] = seconds.count();
+            else
+                this->stats.failed++;
+        }
+    }
+
+    BatchRenderer::Stats BatchRenderer::finish() {
+        /** Wait for all submitted jobs to complete and return their timings
+         *  No more jobs may be submitted afterwards
+         */
+        {
+            std::lock_guard<std::mutex> guard(this->lock);
+            if (this->stopping)
+                return this->stats;
+            this->stopping = true;
+        }
+
+        this->has_job.notify_all();
+        this->has_room.notify_all();
+        for (auto& worker : this->workers)
+            worker.join();
+
+        std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - this->start;
+        this->stats.elapsed = seconds.count();
+        return this->stats;
+    }
+}
@@ -0,0 +1,338 @@
+# include "flexplot.h"
+# include <cstring>
+
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+// Memory-mapped CSV loading
+
+namespace Graphs {
+    MappedFile::MappedFile(const std::string& filename) {
+#ifdef _WIN32
+        HANDLE handle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (handle == INVALID_HANDLE_VALUE)
+            throw std::runtime_error("Couldn't open " + filename);
+        this->file = handle;
+
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(handle, &file_size)) {
+            CloseHandle(handle);
+            throw std::runtime_error("Couldn't get the size of " + filename);
+        }
+
+        this->length = (size_t)file_size.QuadPart;
+        if (!this->length) return; // Empty files can't be mapped
+
+        this->mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (this->mapping)
+            this->ptr = (const char*)MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0);
+
+        if (!this->ptr) {
+            if (this->mapping) CloseHandle(this->mapping);
+            CloseHandle(handle);
+            throw std::runtime_error("Couldn't map " + filename);
+        }
+#else
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("Couldn't open " + filename);
+
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            close(fd);
+            throw std::runtime_error("Couldn't get the size of " + filename);
+        }
+
+        this->length = (size_t)info.st_size;
+        if (this->length) {
+            void* view = mmap(nullptr, this->length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (view == MAP_FAILED) {
+                close(fd);
+                throw std::runtime_error("Couldn't map " + filename);
+            }
+
+            madvise(view, this->length, MADV_SEQUENTIAL);
+            this->ptr = (const char*)view;
+        }
+
+        close(fd); // The mapping stays valid
+#endif
+    }
+
+    MappedFile::~MappedFile() {
+#ifdef _WIN32
+        if (this->ptr) UnmapViewOfFile(this->ptr);
+        if (this->mapping) CloseHandle(this->mapping);
+        if (this->file) CloseHandle(this->file);
+#else
+        if (this->ptr) munmap((void*)this->ptr, this->length);
+#endif
+    }
+
+    namespace {
+        /** Call visit(column, begin, end, escaped) for every field in the
+         *  row starting at p and return the start of the next row.
+         *  Quotes around a field are stripped. escaped is set if the
+         *  field contains doubled quotes which still need unescaping.
+         */
+        template<typename F>
+        const char* parse_row(const char* p, const char* end, const CSVFormat& format, F visit) {
+            for (size_t column = 0; ; column++) {
+                const char *field = p, *field_end;
+                bool escaped = false;
+
+                if (p < end && *p == format.quote) {
+                    field = ++p;
+                    while (p < end) {
+                        if (*p == format.quote) {
+                            if (p + 1 < end && p[1] == format.quote) {
+                                escaped = true;
+                                p += 2;
+                                continue;
+                            }
+                            break;
+                        }
+                        p++;
+                    }
+
+                    field_end = p;
+
+                    // Skip the closing quote and anything up to the next separator
+                    while (p < end && *p != format.delimiter && *p != '\n') p++;
+                }
+                else {
+                    while (p < end && *p != format.delimiter && *p != '\n') p++;
+                    field_end = p;
+                    if (field_end > field && field_end[-1] == '\r') field_end--;
+                }
+
+                visit(column, field, field_end, escaped);
+
+                if (p >= end) return end;
+                if (*p++ == '\n') return p;
+            }
+        }
+
+        template<typename V>
+        inline V parse_number(const char* begin, const char* end) {
+            while (begin < end && (*begin == ' ' || *begin == '\t')) begin++;
+            while (end > begin && (end[-1] == ' ' || end[-1] == '\t')) end--;
+            if (begin < end && *begin == '+') begin++;
+
+            V value;
+            auto result = std::from_chars(begin, end, value);
+            if (begin == end || result.ec != std::errc() || result.ptr != end)
+                return NAN;
+            return value;
+        }
+
+        std::string unescape(const char* begin, const char* end, bool escaped, char quote) {
+            if (!escaped) return std::string(begin, end);
+
+            std::string ret;
+            ret.reserve(end - begin);
+            for (const char* p = begin; p < end; p++) {
+                ret.push_back(*p);
+                if (*p == quote) p++; // Doubled quote
+            }
+
+            return ret;
+        }
+    }
+
+    CSVReader::CSVReader(const std::string& filename, CSVFormat _format) :
+        file(filename), format(_format) {
+        const char *begin = this->file.data(), *end = begin + this->file.size();
+        if (!begin) return;
+        if (end - begin >= 3 && memcmp(begin, "\xEF\xBB\xBF", 3) == 0)
+            begin += 3; // UTF-8 byte order mark
+
+        const char* body = parse_row(begin, end, format,
+            [this](size_t, const char* field, const char* field_end, bool escaped) {
+                this->names.push_back(unescape(field, field_end, escaped, format.quote));
+            });
+
+        /** Scanning a chunk needs the state a row parser would be in at its
+         *  first byte, which isn't known until the chunks before it are
+         *  scanned. Like parse_row(), a quote only opens a field at the
+         *  start of the field, so there are four states:
+         *  FIELD:   At the start of a field
+         *  TEXT:    Inside an unquoted field, or after a closing quote
+         *  QUOTED:  Inside a quoted field
+         *  CLOSING: After a quote inside a quoted field, which closes the
+         *           field unless another quote follows
+         *
+         *  Every chunk is scanned from all four states at once, packed two
+         *  bits each into one byte which is advanced by a table lookup.
+         *  For each starting state, the scan counts the newlines which end
+         *  a row, finds the first one, and records the state at the end.
+         */
+        enum State { FIELD, TEXT, QUOTED, CLOSING };
+        enum Class { OTHER, QUOTE, DELIMITER, NEWLINE };
+
+        uint8_t classes[256] = {};
+        classes[(uint8_t)format.quote] = QUOTE;
+        classes[(uint8_t)format.delimiter] = DELIMITER;
+        classes[(uint8_t)'\n'] = NEWLINE;
+
+        const State next[4][4] = {
+            /* FIELD   */ { TEXT, QUOTED, FIELD, FIELD },
+            /* TEXT    */ { TEXT, TEXT, FIELD, FIELD },
+            /* QUOTED  */ { QUOTED, CLOSING, QUOTED, QUOTED },
+            /* CLOSING */ { TEXT, QUOTED, FIELD, FIELD }
+        };
+
+        uint8_t step[4][256];
+        for (int c = 0; c < 4; c++) {
+            for (int packed = 0; packed < 256; packed++) {
+                int ret = 0;
+                for (int i = 0; i < 4; i++)
+                    ret |= next[(packed >> (2 * i)) & 3][c] << (2 * i);
+                step[c][packed] = (uint8_t)ret;
+            }
+        }
+
+        // Which starting states are outside quotes, so a newline ends a row
+        uint8_t row_ends[256];
+        for (int packed = 0; packed < 256; packed++) {
+            row_ends[packed] = 0;
+            for (int i = 0; i < 4; i++)
+                if (((packed >> (2 * i)) & 3) != QUOTED) row_ends[packed] |= 1 << i;
+        }
+
+        struct Scan {
+            size_t newlines[4] = { 0, 0, 0, 0 };
+            const char* first[4] = { nullptr, nullptr, nullptr, nullptr };
+            uint8_t states = 0; /*< State at the end for each starting state */
+        };
+
+        const size_t length = end - body,
+            chunks = parallel_chunks(length, std::max(format.chunk_size, (size_t)1));
+        std::vector<Scan> scans(chunks);
+
+        parallel_for(length, chunks, [&](size_t chunk_begin, size_t chunk_end, size_t chunk) {
+            Scan& scan = scans[chunk];
+            uint8_t states = FIELD | TEXT << 2 | QUOTED << 4 | CLOSING << 6;
+            size_t newlines[4] = { 0, 0, 0, 0 };
+            const char* p = body + chunk_begin;
+            const char* const stop = body + chunk_end;
+
+            while (p < stop) {
+                const uint8_t c = classes[(uint8_t)*p];
+                if (c == NEWLINE) {
+                    const uint8_t outside = row_ends[states];
+                    for (int i = 0; i < 4; i++) {
+                        newlines[i] += (outside >> i) & 1;
+                        if (!scan.first[i] && (outside >> i) & 1) scan.first[i] = p;
+                    }
+                }
+
+                states = step[c][states];
+                p++;
+
+                // Further plain bytes don't change any state
+                if (c == OTHER)
+                    while (p < stop && !classes[(uint8_t)*p]) p++;
+            }
+
+            for (int i = 0; i < 4; i++)
+                scan.newlines[i] = newlines[i];
+            scan.states = states;
+        });
+
+        // Resolve each chunk's starting state to find where its rows start
+        int state = FIELD;
+        for (size_t i = 0; i < chunks; i++) {
+            const Scan& scan = scans[i];
+            if (i == 0) {
+                this->segments.push_back({ body, end, 0 });
+            }
+            else if (scan.first[state] && scan.first[state] + 1 < end) {
+                this->segments.back().end = scan.first[state] + 1;
+                this->segments.push_back({ scan.first[state] + 1, end, this->rows + 1 });
+            }
+
+            this->rows += scan.newlines[state];
+            state = (scan.states >> (2 * state)) & 3;
+        }
+
+        // Last row without a trailing newline
+        if (body < end && end[-1] != '\n')
+            this->rows++;
+    }
+
+    size_t CSVReader::index_of(const std::string& name) const {
+        auto it = std::find(this->names.begin(), this->names.end(), name);
+        if (it == this->names.end())
+            throw ColumnNotFoundError(name);
+        return it - this->names.begin();
+    }
+
+    template<typename F>
+    void CSVReader::parse(const std::vector<size_t>& columns, F store) {
+        /** Call store(slot, row, begin, end, escaped) for every field in one
+         *  of the selected columns, where slot is the column's position
+         *  in columns. A column selected more than once is stored into
+         *  every slot it was selected for.
+         */
+        if (this->segments.empty()) return;
+
+        std::vector<std::vector<size_t>> slots;
+        for (size_t i = 0; i < columns.size(); i++) {
+            if (slots.size() <= columns[i]) slots.resize(columns[i] + 1);
+            slots[columns[i]].push_back(i);
+        }
+
+        parallel_tasks(this->segments.size(), this->segments.size(), [&](size_t i) {
+            const Segment& segment = this->segments[i];
+            const char* p = segment.begin;
+            size_t row = segment.first_row;
+
+            while (p < segment.end && row < this->rows) {
+                p = parse_row(p, segment.end, format,
+                    [&](size_t column, const char* begin, const char* end, bool escaped) {
+                        if (column < slots.size())
+                            for (size_t slot : slots[column])
+                                store(slot, row, begin, end, escaped);
+                    });
+                row++;
+            }
+        });
+    }
+
+    template<typename V>
+    std::vector<std::vector<V>> CSVReader::numeric_columns(const std::vector<std::string>& names) {
+        /** Parse the named columns, throwing ColumnNotFoundError if one is missing */
+        std::vector<size_t> columns;
+        for (auto& name : names)
+            columns.push_back(this->index_of(name));
+
+        std::vector<std::vector<V>> ret(columns.size(), std::vector<V>(this->rows, (V)NAN));
+        this->parse(columns, [&](size_t slot, size_t row, const char* begin, const char* end, bool) {
+            ret[slot][row] = parse_number<V>(begin, end);
+        });
+
+        return ret;
+    }
+
+    template std::vector<std::vector<float>> CSVReader::numeric_columns(const std::vector<std::string>&);
+    template std::vector<std::vector<double>> CSVReader::numeric_columns(const std::vector<std::string>&);
+    template std::vector<std::vector<long double>> CSVReader::numeric_columns(const std::vector<std::string>&);
+
+    std::vector<std::string> CSVReader::text_column(const std::string& name) {
+        std::vector<std::string> ret(this->rows);
+        this->parse({ this->index_of(name) },
+            [&](size_t, size_t row, const char* begin, const char* end, bool escaped) {
+                ret[row] = unescape(begin, end, escaped, format.quote);
+            });
+
+        return ret;
+    }
+}
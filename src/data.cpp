@@ -4,28 +4,64 @@
 
 namespace Graphs {
     std::string to_string(float number, size_t n) {
-        /** Return a float as a string, cutting it off at 
-         *  n decimal places
-         */
+        /** Return a float as a string, rounded to n decimal places */
+        SVG::NumberFormat format;
+        format.precision = (int)n;
+        format.trim_zeros = false;
+        return SVG::format_number(number, format);
+    }
 
-        std::string temp = std::to_string(number);
-        size_t dec_pos = temp.find_first_of('.');
-        return temp.substr(0, dec_pos + 1 + n);
+    std::vector<long double> uniform_edges(long double min, long double max, size_t bins) {
+        /** Edges of bins equal-width bins from min to max */
+        bins = std::max(bins, (size_t)1);
+        std::vector<long double> edges(bins + 1);
+        for (size_t i = 0; i <= bins; i++)
+            edges[i] = min + i * (max - min) / bins;
+        edges[bins] = max;
+        return edges;
     }
 
-    NumericData::NumericData(
-        const std::vector<long double> x,
-        const std::vector<long double> y,
-        const std::vector<long double> z
-    ): NumericData(x, y) {
-        if (y.size() != z.size())
-            throw std::runtime_error("y and z values have different lengths");
-        this->z_values = z;
+    std::vector<long double> width_edges(long double min, long double max, long double width) {
+        /** Edges at multiples of width, covering min to max */
+        if (!(width > 0))
+            throw std::runtime_error("Bin width must be positive");
+
+        const long double first = floor(min / width);
+        const size_t bins = std::max((size_t)ceil(max / width - first), (size_t)1);
+        std::vector<long double> edges(bins + 1);
+        for (size_t i = 0; i <= bins; i++)
+            edges[i] = (first + i) * width;
+        return edges;
+    }
+
+    CategoricalData histogram(const std::vector<long double>& edges, const std::vector<size_t>& counts) {
+        /** Label each bar "[lower, upper)", or "[lower, upper]" for the last
+         *  one, with enough decimal places to tell the narrowest bin's edges apart
+         */
+        CategoricalData ret;
+        if (edges.size() < 2) return ret;
+
+        long double narrowest = edges.back() - edges.front();
+        for (size_t i = 0; i + 1 < edges.size(); i++)
+            narrowest = std::min(narrowest, edges[i + 1] - edges[i]);
+
+        SVG::NumberFormat format;
+        format.precision = narrowest > 0 ?
+            std::max(std::min((int)ceil(-log10(narrowest)) + 2, 10), 0) : 2;
+
+        for (size_t i = 0; i < counts.size(); i++) {
+            ret.x_values.push_back('[' + SVG::format_number((double)edges[i], format) + ", " +
+                SVG::format_number((double)edges[i + 1], format) +
+                (i + 2 == edges.size() ? ']' : ')'));
+            ret.y_values.push_back((double)counts[i]);
+        }
+
+        return ret;
     }
 
     class CategoricalDataSet : public DatasetCollection<CategoricalData> {
         std::vector<std::string> x_labels(size_t) {
-            return this->datasets.begin()->x_labels();
+            return this->datasets.front()->x_labels();
         }
     };
 
@@ -36,11 +72,12 @@ namespace Graphs {
 
         std::vector<std::string> labels;
         max_labels = std::min(size() + 1, max_labels);
+        const long double min = x_min(), max = x_max();
 
         // Set bin labels to left-hand boundary values
         for (size_t i = 0; i <= max_labels; i++) {
-            labels.push_back(std::to_string(
-                x_min() + i*(x_max() - x_min()) / (max_labels - 1)));
+            labels.push_back(Graphs::to_string(
+                min + i*(max - min) / (max_labels - 1)));
         }
 
         return labels;
@@ -48,55 +85,103 @@ namespace Graphs {
 
     std::vector<std::string> DatasetBase::y_labels(const size_t labels) {
         std::vector<std::string> ret_labels;
+        const long double min = y_min(), max = y_max();
 
         // Set bin labels to left-hand boundary values
         for (size_t i = 0; i <= labels; i++) {
             ret_labels.push_back(Graphs::to_string(
-                y_min() + i*(y_max() - y_min()) / labels));
+                min + i*(max - min) / labels));
         }
 
         return ret_labels;
     }
 
-    long double DatasetCollection<NumericData>::x_min() {
-        /** Return the largest x value in the collection of data */
-        long double min = NAN;
-        for (auto it = datasets.begin(); it != datasets.end(); ++it)
-            if (isnan(min) || it->x_min() < min) min = it->x_min();
-
-        return min;
-    }
-
-    long double DatasetCollection<NumericData>::x_max() {
-        /** Return the largest x value in the collection of data */
-        long double max = NAN;
-        for (auto it = datasets.begin(); it != datasets.end(); ++it)
-            if (isnan(max) || it->x_max() > max) max = it->x_max();
-
-        return max;
-    }
-
-    DatasetCollection<NumericData> NumericData::operator+ (NumericData& other) {
-        /** Append data to the set */
-        DatasetCollection<NumericData> ret;
-        ret.datasets.push_back(*this);
-        ret.datasets.push_back(other);
-        return ret;
-    }
+    Polyline downsample_m4(const Polyline& points) {
+        /** Keep the first, last, lowest and highest vertex of every run of
+         *  consecutive vertices that fall into the same pixel column.
+         *  Rasterizing the result lights exactly the same pixels as the
+         *  full polyline, so the reduction is visually lossless.
+         */
+        Polyline ret;
+        const size_t n = points.size();
+        size_t begin = 0;
+
+        while (begin < n) {
+            const float column = floor(points[begin].first);
+            size_t end = begin + 1, lo = begin, hi = begin;
+
+            for (; end < n && floor(points[end].first) == column; end++) {
+                if (points[end].second < points[lo].second) lo = end;
+                if (points[end].second > points[hi].second) hi = end;
+            }
+
+            // Emit in original order so the path still traces the data
+            size_t keep[4] = { begin, std::min(lo, hi), std::max(lo, hi), end - 1 };
+            for (size_t i = 0; i < 4; i++) {
+                if (i == 0 || keep[i] != keep[i - 1])
+                    ret.push_back(points[keep[i]]);
+            }
+
+            begin = end;
+        }
 
-    DatasetCollection<CategoricalData> CategoricalData::operator+ (CategoricalData& other) {
-        DatasetCollection<CategoricalData> ret;
-        ret.datasets.push_back(*this);
-        ret.datasets.push_back(other);
         return ret;
     }
 
-    std::vector<std::string> DatasetCollection<NumericData>::x_labels(size_t max_labels) {
-        return DatasetBase::x_labels(max_labels);
-    }
+    Polyline downsample_lttb(const Polyline& points, size_t threshold) {
+        /** Largest-Triangle-Three-Buckets (Steinarsson, 2013): split the
+         *  interior vertices into threshold - 2 buckets and keep the vertex
+         *  of each bucket forming the largest triangle with the previously
+         *  kept vertex and the average of the next bucket.
+         */
+        const size_t n = points.size();
+        if (threshold < 3 || threshold >= n) return points;
+
+        Polyline ret;
+        ret.reserve(threshold);
+        ret.push_back(points.front());
+
+        const double bucket = (double)(n - 2) / (double)(threshold - 2);
+        size_t prev = 0;
+
+        for (size_t b = 0; b < threshold - 2; b++) {
+            size_t start = (size_t)(b * bucket) + 1,
+                end = (size_t)((b + 1) * bucket) + 1,
+                next_end = std::min((size_t)((b + 2) * bucket) + 1, n);
+
+            // Average of the next bucket (just the last vertex for the final one)
+            double avg_x = 0, avg_y = 0;
+            if (end >= n - 1) {
+                avg_x = points.back().first;
+                avg_y = points.back().second;
+            }
+            else {
+                for (size_t i = end; i < next_end; i++) {
+                    avg_x += points[i].first;
+                    avg_y += points[i].second;
+                }
+                avg_x /= (double)(next_end - end);
+                avg_y /= (double)(next_end - end);
+            }
+
+            const double px = points[prev].first, py = points[prev].second;
+            double max_area = -1;
+            size_t chosen = start;
+
+            for (size_t i = start; i < end; i++) {
+                double area = fabs((px - avg_x) * (points[i].second - py) -
+                    (px - points[i].first) * (avg_y - py));
+                if (area > max_area) {
+                    max_area = area;
+                    chosen = i;
+                }
+            }
+
+            ret.push_back(points[chosen]);
+            prev = chosen;
+        }
 
-    std::vector<std::string> DatasetCollection<CategoricalData>::x_labels(size_t max_labels) {
-        // Assumes all CategoricalData objects have the same labels
-        return this->datasets.begin()->x_values;
+        ret.push_back(points.back());
+        return ret;
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,647 @@
+# include "flexplot.h"
+
+// DEFLATE compression (RFC 1951) with gzip (RFC 1952) or zlib (RFC 1950) framing
+
+namespace SVG {
+    namespace {
+        const int WSIZE = 1 << 15;      /*< Size of the sliding window */
+        const int WMASK = WSIZE - 1;
+        const int HASH_BITS = 15;
+        const int HASH_SIZE = 1 << HASH_BITS;
+        const int MIN_MATCH = 3;
+        const int MAX_MATCH = 258;
+        const int MIN_LOOKAHEAD = MAX_MATCH + MIN_MATCH + 1;
+        const int MAX_DIST = WSIZE - MIN_LOOKAHEAD;
+        const int TOO_FAR = 4096;       /*< Don't bother with length 3 matches further than this */
+        const int NIL = -1;
+
+        const size_t SYMBOL_BUFFER = 1 << 14; /*< Symbols per block */
+        const size_t STORED_BLOCK = 65535;
+        const size_t OUTPUT_BUFFER = 1 << 16;
+
+        const int L_CODES = 286;
+        const int D_CODES = 30;
+        const int BL_CODES = 19;
+        const int END_BLOCK = 256;
+
+        const int LENGTH_BASE[29] = {
+            3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+            35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+        };
+
+        const int LENGTH_EXTRA[29] = {
+            0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+            3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+        };
+
+        const int DIST_BASE[D_CODES] = {
+            1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+            257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+            8193, 12289, 16385, 24577
+        };
+
+        const int DIST_EXTRA[D_CODES] = {
+            0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+            7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+        };
+
+        /** Order in which code length code lengths are sent */
+        const int BL_ORDER[BL_CODES] = {
+            16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+        };
+
+        /** Compression parameters for each level (see zlib's deflate.c) */
+        struct Config {
+            int max_lazy; /*< Don't look for a lazy match above this length (0 = greedy) */
+            int good;     /*< Search less hard once a match this long is found */
+            int nice;     /*< Stop searching once a match this long is found */
+            int chain;    /*< Maximum hash chain length to follow */
+        };
+
+        const Config CONFIG[10] = {
+            { 0, 0, 0, 0 }, // Level 0 only writes stored blocks
+            { 0, 4, 8, 4 },
+            { 0, 4, 16, 8 },
+            { 0, 4, 32, 32 },
+            { 4, 4, 16, 16 },
+            { 16, 8, 32, 32 },
+            { 16, 8, 128, 128 },
+            { 32, 8, 128, 256 },
+            { 128, 32, 258, 1024 },
+            { 258, 32, 258, 4096 }
+        };
+
+        /** Lookup tables built once on first use */
+        struct Tables {
+            Tables() {
+                for (int code = 0; code < 29; code++) {
+                    for (int i = 0; i < (1 << LENGTH_EXTRA[code]); i++) {
+                        int len = LENGTH_BASE[code] + i;
+                        if (len <= MAX_MATCH) length_code[len - MIN_MATCH] = code;
+                    }
+                }
+                length_code[MAX_MATCH - MIN_MATCH] = 28;
+
+                for (int code = 0; code < D_CODES; code++)
+                    for (int i = 0; i < (1 << DIST_EXTRA[code]); i++)
+                        dist_code[DIST_BASE[code] - 1 + i] = (unsigned char)code;
+
+                for (unsigned int n = 0; n < 256; n++) {
+                    unsigned int c = n;
+                    for (int k = 0; k < 8; k++)
+                        c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                    crc[n] = c;
+                }
+            }
+
+            unsigned char length_code[MAX_MATCH - MIN_MATCH + 1];
+            unsigned char dist_code[WSIZE];
+            unsigned int crc[256];
+        };
+
+        const Tables& tables() {
+            static Tables tab;
+            return tab;
+        }
+
+        inline unsigned int reverse_bits(unsigned int code, int len) {
+            unsigned int ret = 0;
+            for (int i = 0; i < len; i++, code >>= 1)
+                ret = (ret << 1) | (code & 1);
+            return ret;
+        }
+
+        void build_lengths(const std::vector<unsigned int>& freq,
+            std::vector<unsigned char>& lengths, int max_bits) {
+            /** Compute Huffman code lengths no longer than max_bits
+             *  If the limit is exceeded, frequencies are flattened and
+             *  the tree is rebuilt until it fits.
+             */
+            const size_t n = freq.size();
+            std::vector<unsigned int> weight(freq);
+            lengths.assign(n, 0);
+
+            std::vector<size_t> used;
+            for (size_t i = 0; i < n; i++)
+                if (weight[i]) used.push_back(i);
+
+            // A valid code needs at least two symbols
+            if (used.empty())
+                return;
+            for (size_t i = 0; used.size() < 2; i++) {
+                if (!weight[i]) {
+                    weight[i] = 1;
+                    used.push_back(i);
+                }
+            }
+
+            std::vector<int> parent;
+            std::vector<std::pair<unsigned long long, int>> heap;
+            auto greater = [](const std::pair<unsigned long long, int>& a,
+                const std::pair<unsigned long long, int>& b) { return a > b; };
+
+            while (true) {
+                parent.assign(used.size(), -1);
+                heap.clear();
+                for (size_t i = 0; i < used.size(); i++)
+                    heap.push_back(std::make_pair((unsigned long long)weight[used[i]], (int)i));
+                std::make_heap(heap.begin(), heap.end(), greater);
+
+                // Repeatedly join the two lightest nodes
+                while (heap.size() > 1) {
+                    std::pop_heap(heap.begin(), heap.end(), greater);
+                    auto a = heap.back();
+                    heap.pop_back();
+                    std::pop_heap(heap.begin(), heap.end(), greater);
+                    auto b = heap.back();
+                    heap.pop_back();
+
+                    int node = (int)parent.size();
+                    parent.push_back(-1);
+                    parent[a.second] = parent[b.second] = node;
+                    heap.push_back(std::make_pair(a.first + b.first, node));
+                    std::push_heap(heap.begin(), heap.end(), greater);
+                }
+
+                // Depth of each leaf is its code length
+                int longest = 0;
+                for (size_t i = 0; i < used.size(); i++) {
+                    int depth = 0;
+                    for (int p = parent[i]; p != -1; p = parent[p]) depth++;
+                    lengths[used[i]] = (unsigned char)depth;
+                    longest = std::max(longest, depth);
+                }
+
+                if (longest <= max_bits)
+                    return;
+
+                for (size_t i = 0; i < used.size(); i++)
+                    weight[used[i]] = (weight[used[i]] + 1) / 2;
+            }
+        }
+
+        void build_codes(const std::vector<unsigned char>& lengths,
+            std::vector<unsigned int>& codes) {
+            /** Assign canonical Huffman codes, bit-reversed for output */
+            int bl_count[16] = { 0 };
+            unsigned int next_code[16] = { 0 };
+            for (auto it = lengths.begin(); it != lengths.end(); ++it)
+                if (*it) bl_count[*it]++;
+
+            unsigned int code = 0;
+            for (int bits = 1; bits < 16; bits++) {
+                code = (code + bl_count[bits - 1]) << 1;
+                next_code[bits] = code;
+            }
+
+            codes.assign(lengths.size(), 0);
+            for (size_t i = 0; i < lengths.size(); i++)
+                if (lengths[i])
+                    codes[i] = reverse_bits(next_code[lengths[i]]++, lengths[i]);
+        }
+    }
+
+    Deflater::Deflater(std::ostream& _out, int _level, Framing _framing) :
+        out(_out), level(std::min(std::max(_level, 0), 9)), framing(_framing),
+        window(2 * WSIZE + MAX_MATCH), head(HASH_SIZE, NIL), prev(WSIZE, NIL),
+        lit_freq(L_CODES, 0), dist_freq(D_CODES, 0) {
+        tables(); // Build lookup tables up front
+
+        if (framing == GZIP) {
+            const char header[10] = {
+                (char)0x1f, (char)0x8b, 8, 0,   // Magic, deflate, no flags
+                0, 0, 0, 0,                     // No modification time
+                (char)(level == 9 ? 2 : (level == 1 ? 4 : 0)),
+                (char)255                       // Unknown OS
+            };
+            output.append(header, sizeof(header));
+        }
+        else if (framing == ZLIB) {
+            const int cmf = 0x78;
+            int flg = (level < 2 ? 0 : (level < 6 ? 1 : (level == 6 ? 2 : 3))) << 6;
+            flg += 31 - (cmf * 256 + flg) % 31;
+            output.push_back((char)cmf);
+            output.push_back((char)flg);
+        }
+    }
+
+    Deflater::~Deflater() {
+        if (!finished)
+            finish();
+    }
+
+    void Deflater::write(const char* data, size_t len) {
+        /** Compress data, writing completed blocks to the output stream */
+        update_checksum(data, len);
+        total_in += len;
+
+        if (level == 0) {
+            stored.insert(stored.end(), data, data + len);
+            while (stored.size() >= STORED_BLOCK) {
+                write_stored(stored.data(), STORED_BLOCK, false);
+                stored.erase(stored.begin(), stored.begin() + STORED_BLOCK);
+            }
+            return;
+        }
+
+        while (len > 0) {
+            if (strstart + lookahead >= 2 * WSIZE)
+                slide_window();
+
+            size_t n = std::min(len, (size_t)(2 * WSIZE - (strstart + lookahead)));
+            std::copy(data, data + n, window.begin() + strstart + lookahead);
+            lookahead += (int)n;
+            data += n;
+            len -= n;
+
+            compress(false);
+        }
+    }
+
+    void Deflater::finish() {
+        /** Compress any remaining input and write the stream trailer */
+        if (finished)
+            return;
+
+        if (level == 0) {
+            write_stored(stored.data(), stored.size(), true);
+            stored.clear();
+        }
+        else {
+            compress(true);
+            flush_block(true);
+        }
+
+        align();
+        if (framing == GZIP) {
+            put_bytes(checksum, 4, false);
+            put_bytes((unsigned int)total_in, 4, false);
+        }
+        else if (framing == ZLIB) {
+            put_bytes(checksum, 4, true);
+        }
+
+        flush_output();
+        finished = true;
+    }
+
+    unsigned int crc32(const char* data, size_t len, unsigned int crc) {
+        /** Update a CRC-32 (as used by gzip and PNG) with len more bytes */
+        const unsigned char* bytes = (const unsigned char*)data;
+        const unsigned int* table = tables().crc;
+        unsigned int c = ~crc;
+        for (size_t i = 0; i < len; i++)
+            c = table[(c ^ bytes[i]) & 0xff] ^ (c >> 8);
+        return ~c;
+    }
+
+    void Deflater::update_checksum(const char* data, size_t len) {
+        const unsigned char* bytes = (const unsigned char*)data;
+        if (framing == GZIP) {
+            checksum = crc32(data, len, checksum);
+        }
+        else if (framing == ZLIB) {
+            unsigned int a = checksum & 0xffff, b = checksum >> 16;
+            while (len > 0) {
+                // Largest n such that b can't overflow before the modulo
+                size_t n = std::min(len, (size_t)5552);
+                len -= n;
+                for (; n > 0; n--) {
+                    a += *bytes++;
+                    b += a;
+                }
+                a %= 65521;
+                b %= 65521;
+            }
+            checksum = (b << 16) | a;
+        }
+    }
+
+    void Deflater::slide_window() {
+        /** Move the upper half of the window down to make room for input */
+        std::copy(window.begin() + WSIZE, window.begin() + 2 * WSIZE, window.begin());
+        strstart -= WSIZE;
+        match_start -= WSIZE;
+        prev_match -= WSIZE;
+
+        for (auto it = head.begin(); it != head.end(); ++it)
+            *it = *it >= WSIZE ? *it - WSIZE : NIL;
+        for (auto it = prev.begin(); it != prev.end(); ++it)
+            *it = *it >= WSIZE ? *it - WSIZE : NIL;
+    }
+
+    inline int Deflater::insert_string(int pos) {
+        /** Add the 3 bytes at pos to the hash table and return the previous
+         *  position with the same hash
+         */
+        unsigned int key = ((unsigned int)window[pos] << 16) |
+            ((unsigned int)window[pos + 1] << 8) | window[pos + 2];
+        unsigned int hash = (key * 2654435761u) >> (32 - HASH_BITS);
+
+        int ret = head[hash];
+        prev[pos & WMASK] = ret;
+        head[hash] = pos;
+        return ret;
+    }
+
+    int Deflater::longest_match(int cur_match) {
+        /** Follow the hash chain from cur_match and return the length of
+         *  the longest match, setting match_start
+         */
+        const Config& config = CONFIG[level];
+        const int limit = strstart - MAX_DIST;
+        const int max_len = std::min(MAX_MATCH, lookahead);
+        const int nice = std::min(config.nice, lookahead);
+        const unsigned char* scan = window.data() + strstart;
+        int chain = config.chain;
+        int best_len = std::max(prev_length, MIN_MATCH - 1);
+
+        if (best_len >= max_len)
+            return MIN_MATCH - 1;
+        if (prev_length >= config.good)
+            chain >>= 2;
+
+        do {
+            const unsigned char* match = window.data() + cur_match;
+            if (match[best_len] != scan[best_len] ||
+                match[0] != scan[0] || match[1] != scan[1])
+                continue;
+
+            int len = 2;
+            while (len < max_len && match[len] == scan[len])
+                len++;
+
+            if (len > best_len) {
+                match_start = cur_match;
+                best_len = len;
+                if (len >= nice)
+                    break;
+            }
+        } while ((cur_match = prev[cur_match & WMASK]) > limit
+            && cur_match != NIL && --chain != 0);
+
+        return best_len;
+    }
+
+    void Deflater::compress(bool flush) {
+        /** Run LZ77 over buffered input
+         *
+         *  Unless flushing, stop once less than MIN_LOOKAHEAD bytes remain,
+         *  so a match is never cut short by the end of the available input.
+         */
+        const Config& config = CONFIG[level];
+
+        while (lookahead > 0) {
+            if (lookahead < MIN_LOOKAHEAD && !flush)
+                return;
+
+            const int data_end = strstart + lookahead;
+            int hash_head = NIL;
+            if (lookahead >= MIN_MATCH)
+                hash_head = insert_string(strstart);
+
+            prev_length = match_length;
+            prev_match = match_start;
+            match_length = MIN_MATCH - 1;
+
+            if (hash_head != NIL && strstart - hash_head <= MAX_DIST &&
+                (config.max_lazy == 0 || prev_length < config.max_lazy)) {
+                match_length = longest_match(hash_head);
+                if (match_length == MIN_MATCH && strstart - match_start > TOO_FAR)
+                    match_length = MIN_MATCH - 1;
+            }
+
+            if (config.max_lazy == 0) {
+                // Greedy matching: take any match immediately
+                if (match_length >= MIN_MATCH) {
+                    tally_match(strstart - match_start, match_length);
+                    int end = strstart + match_length;
+                    lookahead -= match_length;
+                    for (strstart++; strstart < end; strstart++)
+                        if (strstart + MIN_MATCH <= data_end) insert_string(strstart);
+                }
+                else {
+                    tally_literal(window[strstart]);
+                    strstart++;
+                    lookahead--;
+                }
+
+                match_length = MIN_MATCH - 1;
+            }
+            else if (prev_length >= MIN_MATCH && match_length <= prev_length) {
+                // The match at the previous position is at least as good
+                tally_match(strstart - 1 - prev_match, prev_length);
+                int end = strstart - 1 + prev_length;
+                lookahead -= prev_length - 1;
+                for (strstart++; strstart < end; strstart++)
+                    if (strstart + MIN_MATCH <= data_end) insert_string(strstart);
+
+                match_available = false;
+                match_length = MIN_MATCH - 1;
+            }
+            else if (match_available) {
+                // Previous position had no (better) match: emit it as a literal
+                tally_literal(window[strstart - 1]);
+                strstart++;
+                lookahead--;
+            }
+            else {
+                // Defer this position in case the next one matches better
+                match_available = true;
+                strstart++;
+                lookahead--;
+            }
+
+            if (sym_dist.size() >= SYMBOL_BUFFER)
+                flush_block(false);
+        }
+
+        if (flush && match_available) {
+            tally_literal(window[strstart - 1]);
+            match_available = false;
+        }
+    }
+
+    inline void Deflater::tally_literal(unsigned char c) {
+        sym_lc.push_back(c);
+        sym_dist.push_back(0);
+        lit_freq[c]++;
+    }
+
+    inline void Deflater::tally_match(int dist, int len) {
+        const Tables& tab = tables();
+        sym_lc.push_back((unsigned char)(len - MIN_MATCH));
+        sym_dist.push_back((unsigned short)dist);
+        lit_freq[tab.length_code[len - MIN_MATCH] + END_BLOCK + 1]++;
+        dist_freq[tab.dist_code[dist - 1]]++;
+    }
+
+    void Deflater::flush_block(bool final) {
+        /** Encode buffered symbols as a fixed or dynamic Huffman block,
+         *  whichever is smaller
+         */
+        lit_freq[END_BLOCK]++;
+
+        std::vector<unsigned char> lit_len, dist_len, bl_len;
+        build_lengths(lit_freq, lit_len, 15);
+        build_lengths(dist_freq, dist_len, 15);
+
+        // Run-length encode the code lengths of both trees
+        int hlit = L_CODES, hdist = D_CODES;
+        while (hlit > 257 && lit_len[hlit - 1] == 0) hlit--;
+        while (hdist > 1 && dist_len[hdist - 1] == 0) hdist--;
+
+        std::vector<unsigned char> lengths(lit_len.begin(), lit_len.begin() + hlit);
+        lengths.insert(lengths.end(), dist_len.begin(), dist_len.begin() + hdist);
+
+        std::vector<std::pair<int, int>> bl_symbols; // (symbol, extra bits value)
+        std::vector<unsigned int> bl_freq(BL_CODES, 0);
+        for (size_t i = 0; i < lengths.size();) {
+            size_t run = 1;
+            while (i + run < lengths.size() && lengths[i + run] == lengths[i]) run++;
+
+            if (lengths[i] == 0 && run >= 3) {
+                run = std::min(run, (size_t)138);
+                if (run <= 10)
+                    bl_symbols.push_back(std::make_pair(17, (int)run - 3));
+                else
+                    bl_symbols.push_back(std::make_pair(18, (int)run - 11));
+            }
+            else if (lengths[i] != 0 && run >= 4) {
+                run = std::min(run, (size_t)7);
+                bl_symbols.push_back(std::make_pair((int)lengths[i], 0));
+                bl_symbols.push_back(std::make_pair(16, (int)run - 4));
+            }
+            else {
+                run = 1;
+                bl_symbols.push_back(std::make_pair((int)lengths[i], 0));
+            }
+
+            i += run;
+        }
+
+        for (auto it = bl_symbols.begin(); it != bl_symbols.end(); ++it)
+            bl_freq[it->first]++;
+        build_lengths(bl_freq, bl_len, 7);
+
+        int hclen = BL_CODES;
+        while (hclen > 4 && bl_len[BL_ORDER[hclen - 1]] == 0) hclen--;
+
+        // Compare the cost of both block types
+        std::vector<unsigned char> fixed_lit(288), fixed_dist(D_CODES, 5);
+        for (int i = 0; i < 288; i++)
+            fixed_lit[i] = i < 144 ? 8 : (i < 256 ? 9 : (i < 280 ? 7 : 8));
+
+        unsigned long long dynamic_bits = 14 + 3 * (unsigned long long)hclen;
+        unsigned long long fixed_bits = 0;
+        for (auto it = bl_symbols.begin(); it != bl_symbols.end(); ++it)
+            dynamic_bits += bl_len[it->first] +
+                (it->first == 16 ? 2 : (it->first == 17 ? 3 : (it->first == 18 ? 7 : 0)));
+        for (int i = 0; i < L_CODES; i++) {
+            dynamic_bits += (unsigned long long)lit_freq[i] * lit_len[i];
+            fixed_bits += (unsigned long long)lit_freq[i] * fixed_lit[i];
+        }
+        for (int i = 0; i < D_CODES; i++) {
+            dynamic_bits += (unsigned long long)dist_freq[i] * dist_len[i];
+            fixed_bits += (unsigned long long)dist_freq[i] * 5;
+        }
+
+        std::vector<unsigned int> lit_codes, dist_codes;
+        put_bits(final ? 1 : 0, 1);
+
+        if (dynamic_bits < fixed_bits) {
+            std::vector<unsigned int> bl_codes;
+            build_codes(bl_len, bl_codes);
+            build_codes(lit_len, lit_codes);
+            build_codes(dist_len, dist_codes);
+
+            put_bits(2, 2);
+            put_bits(hlit - 257, 5);
+            put_bits(hdist - 1, 5);
+            put_bits(hclen - 4, 4);
+            for (int i = 0; i < hclen; i++)
+                put_bits(bl_len[BL_ORDER[i]], 3);
+
+            for (auto it = bl_symbols.begin(); it != bl_symbols.end(); ++it) {
+                put_bits(bl_codes[it->first], bl_len[it->first]);
+                if (it->first == 16) put_bits(it->second, 2);
+                else if (it->first == 17) put_bits(it->second, 3);
+                else if (it->first == 18) put_bits(it->second, 7);
+            }
+        }
+        else {
+            lit_len = fixed_lit;
+            dist_len = fixed_dist;
+            build_codes(lit_len, lit_codes);
+            build_codes(dist_len, dist_codes);
+            put_bits(1, 2);
+        }
+
+        // Write out the compressed data
+        const Tables& tab = tables();
+        for (size_t i = 0; i < sym_dist.size(); i++) {
+            if (sym_dist[i] == 0) {
+                put_bits(lit_codes[sym_lc[i]], lit_len[sym_lc[i]]);
+                continue;
+            }
+
+            int len_code = tab.length_code[sym_lc[i]];
+            int sym = len_code + END_BLOCK + 1;
+            put_bits(lit_codes[sym], lit_len[sym]);
+            put_bits(sym_lc[i] + MIN_MATCH - LENGTH_BASE[len_code], LENGTH_EXTRA[len_code]);
+
+            int dist = sym_dist[i];
+            int dist_code = tab.dist_code[dist - 1];
+            put_bits(dist_codes[dist_code], dist_len[dist_code]);
+            put_bits(dist - DIST_BASE[dist_code], DIST_EXTRA[dist_code]);
+        }
+
+        put_bits(lit_codes[END_BLOCK], lit_len[END_BLOCK]);
+
+        sym_lc.clear();
+        sym_dist.clear();
+        std::fill(lit_freq.begin(), lit_freq.end(), 0);
+        std::fill(dist_freq.begin(), dist_freq.end(), 0);
+
+        if (output.size() >= OUTPUT_BUFFER)
+            flush_output();
+    }
+
+    void Deflater::write_stored(const char* data, size_t len, bool final) {
+        put_bits(final ? 1 : 0, 1);
+        put_bits(0, 2);
+        align();
+        put_bytes((unsigned int)len, 2, false);
+        put_bytes((unsigned int)~len & 0xffff, 2, false);
+        output.append(data, len);
+        flush_output();
+    }
+
+    inline void Deflater::put_bits(unsigned int value, int bits) {
+        bit_buffer |= (unsigned long long)value << bit_count;
+        bit_count += bits;
+        while (bit_count >= 8) {
+            output.push_back((char)(bit_buffer & 0xff));
+            bit_buffer >>= 8;
+            bit_count -= 8;
+        }
+    }
+
+    void Deflater::put_bytes(unsigned int value, int bytes, bool big_endian) {
+        for (int i = 0; i < bytes; i++) {
+            int shift = big_endian ? 8 * (bytes - 1 - i) : 8 * i;
+            output.push_back((char)((value >> shift) & 0xff));
+        }
+    }
+
+    void Deflater::align() {
+        /** Pad the bit stream to a byte boundary */
+        if (bit_count > 0)
+            put_bits(0, 8 - bit_count);
+    }
+
+    void Deflater::flush_output() {
+        out.write(output.data(), output.size());
+        output.clear();
+    }
+}
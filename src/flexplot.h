@@ -9,107 +9,606 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <new>       // placement new
+#include <cstddef>   // max_align_t
+#include <type_traits>
+#include <limits>
+#include <cstdint>
+#include <charconv>  // to_chars
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <exception> // exception_ptr
 
 using std::vector;
 using std::string;
 
 namespace SVG {
+    /** Controls how numbers are converted to text */
+    struct NumberFormat {
+        enum Mode {
+            FIXED,   /*< At most `precision` decimal places */
+            SHORTEST /*< Shortest text which reads back as the same float */
+        };
+
+        Mode mode = FIXED;
+        int precision = 2;
+        bool trim_zeros = true; /*< Drop trailing zeros in FIXED mode */
+    };
+
+    char* format_number(char* first, char* last, float number,
+        const NumberFormat& format = NumberFormat());
+    std::string format_number(float number, const NumberFormat& format = NumberFormat());
+
+    // Keep double precision, e.g. for labels of values too large for float
+    char* format_number(char* first, char* last, double number,
+        const NumberFormat& format = NumberFormat());
+    std::string format_number(double number, const NumberFormat& format = NumberFormat());
+
+    /** Buffered byte sink used to serialize element trees
+     *
+     *  If constructed with an output stream, the buffer is flushed to
+     *  that stream whenever it fills up. Otherwise, output accumulates
+     *  in memory and can be retrieved with str().
+     */
+    class Writer {
+    public:
+        Writer(NumberFormat _format = NumberFormat()) : format(_format) {};
+        Writer(std::ostream& _out, NumberFormat _format = NumberFormat()) :
+            format(_format), out(&_out) {
+            buffer.reserve(BUFFER_SIZE);
+        };
+
+        ~Writer() { flush(); }
+
+        inline Writer& write(const char* data, size_t len) {
+            buffer.append(data, len);
+            if (out && buffer.size() >= BUFFER_SIZE)
+                flush();
+            return *this;
+        }
+
+        inline Writer& operator<<(const std::string& str) {
+            return write(str.data(), str.size());
+        }
+
+        inline Writer& operator<<(const char* str) {
+            return write(str, std::char_traits<char>::length(str));
+        }
+
+        inline Writer& operator<<(char c) {
+            return write(&c, 1);
+        }
+
+        inline Writer& operator<<(float number) {
+            char temp[64];
+            char* end = format_number(temp, temp + sizeof(temp), number, this->format);
+            return write(temp, end - temp);
+        }
+
+        inline Writer& operator<<(int number) {
+            char temp[16];
+            auto result = std::to_chars(temp, temp + sizeof(temp), number);
+            return write(temp, result.ptr - temp);
+        }
+
+        inline void flush() {
+            /** Write buffered output to the underlying stream (if any) */
+            if (out && !buffer.empty()) {
+                out->write(buffer.data(), buffer.size());
+                buffer.clear();
+            }
+        }
+
+        inline std::string& str() { return buffer; }
+
+        NumberFormat format;
+
+    private:
+        static const size_t BUFFER_SIZE = 1 << 16;
+        std::ostream* out = nullptr;
+        std::string buffer;
+    };
+
+    unsigned int crc32(const char* data, size_t len, unsigned int crc = 0);
+
+    /** Streaming DEFLATE compressor
+     *
+     *  Compresses data as it is written and passes completed blocks on to
+     *  an output stream, wrapped in gzip (RFC 1952) or zlib (RFC 1950)
+     *  framing. Levels range from 0 (store only) to 9 (smallest output).
+     */
+    class Deflater {
+    public:
+        enum Framing { RAW, GZIP, ZLIB };
+
+        Deflater(std::ostream& _out, int _level = 6, Framing _framing = GZIP);
+        Deflater(const Deflater&) = delete;
+        Deflater& operator=(const Deflater&) = delete;
+        ~Deflater();
+
+        void write(const char* data, size_t len);
+        void finish();
+
+    private:
+        void update_checksum(const char* data, size_t len);
+        void slide_window();
+        int insert_string(int pos);
+        int longest_match(int cur_match);
+        void compress(bool flush);
+        void tally_literal(unsigned char c);
+        void tally_match(int dist, int len);
+        void flush_block(bool final);
+        void write_stored(const char* data, size_t len, bool final);
+        void put_bits(unsigned int value, int bits);
+        void put_bytes(unsigned int value, int bytes, bool big_endian);
+        void align();
+        void flush_output();
+
+        std::ostream& out;
+        int level;
+        Framing framing;
+        bool finished = false;
+        unsigned int checksum = (framing == ZLIB) ? 1 : 0;
+        size_t total_in = 0;
+
+        // LZ77 state
+        std::vector<unsigned char> window;
+        std::vector<int> head;
+        std::vector<int> prev;
+        int strstart = 0;
+        int lookahead = 0;
+        int match_start = 0;
+        int match_length = 2;
+        int prev_match = 0;
+        int prev_length = 2;
+        bool match_available = false;
+
+        // Symbols for the current block
+        std::vector<unsigned char> sym_lc;   /*< Literal byte or match length - 3 */
+        std::vector<unsigned short> sym_dist; /*< Match distance, or 0 for literals */
+        std::vector<unsigned int> lit_freq;
+        std::vector<unsigned int> dist_freq;
+        std::vector<char> stored;            /*< Pending input for level 0 */
+
+        // Bit output
+        unsigned long long bit_buffer = 0;
+        int bit_count = 0;
+        std::string output;
+    };
+
+    /** Output stream which compresses everything written to it
+     *  Call finish() (or destroy the stream) to complete the output
+     */
+    class DeflateStream : public std::ostream {
+    public:
+        DeflateStream(std::ostream& out, int level = 6,
+            Deflater::Framing framing = Deflater::GZIP) :
+            std::ostream(nullptr), buffer(out, level, framing) {
+            this->rdbuf(&buffer);
+        }
+
+        inline void finish() { buffer.deflater.finish(); }
+
+    private:
+        class Buffer : public std::streambuf {
+        public:
+            Buffer(std::ostream& out, int level, Deflater::Framing framing) :
+                deflater(out, level, framing) {};
+
+            Deflater deflater;
+
+        protected:
+            std::streamsize xsputn(const char* data, std::streamsize len) override {
+                deflater.write(data, (size_t)len);
+                return len;
+            }
+
+            int_type overflow(int_type c) override {
+                if (!traits_type::eq_int_type(c, traits_type::eof())) {
+                    char ch = traits_type::to_char_type(c);
+                    deflater.write(&ch, 1);
+                }
+
+                return traits_type::not_eof(c);
+            }
+        };
+
+        Buffer buffer;
+    };
+
+    std::string base64(const std::string& data);
+
+    /** Anti-aliased software rasterizer for dense data layers
+     *
+     *  Pixels are kept as premultiplied RGBA floats and composited with
+     *  "source over". The finished image can be encoded as a PNG, either
+     *  raw or as a data URI for an <image> element.
+     */
+    class Raster {
+    public:
+        struct Color {
+            float r, g, b, a;
+        };
+
+        Raster(size_t _width, size_t _height) :
+            width(_width), height(_height), pixels(4 * _width * _height) {};
+
+        static Color parse_color(const std::string& color, float opacity = 1);
+
+        void fill_circle(float cx, float cy, float r, const Color& color);
+        void draw_line(float x0, float y0, float x1, float y1, float line_width,
+            const Color& color);
+
+        std::string to_png() const;
+        std::string to_data_uri() const;
+
+        inline size_t get_width() const { return width; }
+        inline size_t get_height() const { return height; }
+        inline Color pixel(size_t x, size_t y) const {
+            const float* p = &pixels[4 * (y * width + x)];
+            return { p[0], p[1], p[2], p[3] };
+        }
+
+    private:
+        inline void blend(size_t x, size_t y, const Color& color, float coverage) {
+            float* p = &pixels[4 * (y * width + x)];
+            float a = color.a * coverage;
+            p[0] = color.r * a + p[0] * (1 - a);
+            p[1] = color.g * a + p[1] * (1 - a);
+            p[2] = color.b * a + p[2] * (1 - a);
+            p[3] = a + p[3] * (1 - a);
+        }
+
+        size_t width;
+        size_t height;
+        std::vector<float> pixels;
+    };
+
+    typedef unsigned short AttrKey;
+
+    /** Interned attribute names
+     *
+     *  Common SVG attributes are pre-registered so their keys are
+     *  compile-time constants. Any other name gets a key the first
+     *  time it is passed to intern().
+     */
+    namespace Attr {
+        enum : AttrKey {
+            X, Y, X1, X2, Y1, Y2, CX, CY, R, WIDTH, HEIGHT, D,
+            XMLNS, FILL, FILL_OPACITY, STROKE, STROKE_WIDTH, STROKE_OPACITY,
+            STROKE_DASHARRAY, STYLE, TRANSFORM, TEXT_ANCHOR,
+            DOMINANT_BASELINE, FONT_FAMILY, FONT_SIZE, CLASS, HREF,
+            PRESERVE_ASPECT_RATIO, NUM_BUILTIN
+        };
+
+        AttrKey intern(const std::string& name);
+        const std::string& name(AttrKey key);
+    }
+
+    /** Flat, insertion-ordered attribute storage
+     *
+     *  Numbers are stored natively and only formatted when the
+     *  element is written out.
+     */
+    class Attributes {
+    public:
+        enum Type : unsigned char { STRING, FLOAT, INT };
+
+        struct Entry {
+            AttrKey key;
+            Type type;
+            union {
+                float number;
+                int integer;
+                unsigned int index; /*< Position in Attributes::strings */
+            };
+        };
+
+        template<typename T>
+        inline void set(AttrKey key, T value) {
+            set_number(key, value, std::is_integral<T>());
+        }
+
+        inline void set(AttrKey key, const std::string& value) {
+            Entry& entry = this->slot(key);
+            if (entry.type != STRING) {
+                entry.type = STRING;
+                entry.index = (unsigned int)strings.size();
+                strings.push_back(value);
+            }
+            else {
+                strings[entry.index] = value;
+            }
+        }
+
+        inline void set(AttrKey key, const char * value) {
+            set(key, std::string(value));
+        }
+
+        inline const Entry* find(AttrKey key) const {
+            for (auto it = entries.begin(); it != entries.end(); ++it)
+                if (it->key == key) return &(*it);
+            return nullptr;
+        }
+
+        inline bool has(AttrKey key) const { return find(key) != nullptr; }
+
+        inline void erase(AttrKey key) {
+            for (auto it = entries.begin(); it != entries.end(); ++it) {
+                if (it->key == key) {
+                    entries.erase(it);
+                    return;
+                }
+            }
+        }
+
+        float get_float(AttrKey key) const;
+        std::string get_string(AttrKey key) const;
+        void write(Writer& out) const;
+
+        inline std::vector<Entry>::const_iterator begin() const { return entries.begin(); }
+        inline std::vector<Entry>::const_iterator end() const { return entries.end(); }
+        inline size_t size() const { return entries.size(); }
+        inline bool empty() const { return entries.empty(); }
+
+    private:
+        inline Entry& slot(AttrKey key) {
+            /** Return the entry for key, creating it if necessary */
+            for (auto it = entries.begin(); it != entries.end(); ++it)
+                if (it->key == key) return *it;
+
+            Entry entry;
+            entry.key = key;
+            entry.type = FLOAT;
+            entry.number = 0;
+            entries.push_back(entry);
+            return entries.back();
+        }
+
+        template<typename T>
+        inline void set_number(AttrKey key, T value, std::true_type) {
+            Entry& entry = this->slot(key);
+            entry.type = INT;
+            entry.integer = (int)value;
+        }
+
+        template<typename T>
+        inline void set_number(AttrKey key, T value, std::false_type) {
+            Entry& entry = this->slot(key);
+            entry.type = FLOAT;
+            entry.number = (float)value;
+        }
+
+        std::vector<Entry> entries;
+        std::vector<std::string> strings;
+    };
+
+    class Element;
+
+    /** Owns the nodes of an element tree
+     *
+     *  Children are constructed inside large contiguous blocks rather than
+     *  individually on the heap, and are all destroyed in one shot along
+     *  with the pool. When a subtree is attached to another tree, its pool
+     *  is absorbed by splicing block lists, so existing nodes never move.
+     */
+    class NodePool {
+    public:
+        NodePool() {};
+        NodePool(const NodePool&) = delete;
+        NodePool& operator=(const NodePool&) = delete;
+        ~NodePool();
+
+        template<typename T, typename... Args>
+        T* make(Args&&... args);
+
+        void release(Element* node);
+        void absorb(std::unique_ptr<NodePool> other);
+        NodePool& resolve();
+
+    private:
+        struct Block {
+            Block* next;
+            size_t capacity;
+            size_t used;
+        };
+
+        struct Header {
+            Element* node;
+            size_t stride;
+        };
+
+        static const size_t ALIGN = alignof(std::max_align_t);
+        static const size_t MIN_BLOCK = 1 << 10;
+        static const size_t MAX_BLOCK = 1 << 16;
+
+        static inline size_t round_up(size_t size) {
+            return (size + ALIGN - 1) / ALIGN * ALIGN;
+        }
+
+        static inline char* data(Block* block) {
+            return (char*)block + round_up(sizeof(Block));
+        }
+
+        void* allocate(size_t size);
+
+        Block* head = nullptr; /*< Block currently being filled */
+        Block* tail = nullptr;
+        size_t next_block = MIN_BLOCK;
+        NodePool* forward = nullptr; /*< Pool this one was absorbed into */
+        std::vector<std::unique_ptr<NodePool>> absorbed;
+        std::map<size_t, std::vector<Header*>> free_slots; /*< Released nodes' memory, by stride */
+    };
+
     class Element {
     public:
         Element() {};
-        Element(
-            std::string _tag,
-            std::map < std::string, std::string > _attr) :
-            attr(_attr),
-            tag(_tag) {};
+        Element(std::string _tag) : tag(_tag) {};
+        Element(const Element& other);
+        Element(Element&& other);
+        virtual ~Element() {};
+
+        Element& operator=(const Element& other);
+        Element& operator=(Element&& other);
 
         template<typename T>
-        inline Element& set_attr(std::string key, T value) {
-            this->attr[key] = std::to_string(value);
+        inline Element& set_attr(const std::string& key, T value) {
+            this->attr.set(Attr::intern(key), value);
             return *this;
         }
 
-        template<typename T, typename... Args>
-        inline void add_child(T node, Args... args) {
-            add_child(node);
-            add_child(args...);
+        template<typename T>
+        inline Element& set_attr(AttrKey key, T value) {
+            this->attr.set(key, value);
+            return *this;
+        }
+
+        template<typename T, typename U, typename... Args>
+        inline void add_child(T&& node, U&& next, Args&&... args) {
+            add_child(std::forward<T>(node));
+            add_child(std::forward<U>(next), std::forward<Args>(args)...);
         }
 
         template<typename T>
-        inline Element* add_child(T node) {
-            /** Also return a pointer to the element added */
-            this->children.push_back(std::make_shared<T>(node));
-            return this->children.back().get();
+        inline typename std::decay<T>::type* add_child(T&& node) {
+            /** Also return a pointer to the element added
+             *  Pass an rvalue to move the node (and its subtree) in without copying
+             */
+            return this->emplace_child<typename std::decay<T>::type>(
+                std::forward<T>(node));
+        }
+
+        void append_children(Element&& other);
+
+        inline void discard(Element* node) {
+            /** Destroy a subtree which has been detached from this tree,
+             *  so its memory is reused by the next nodes created
+             */
+            this->get_pool().release(node);
+        }
+
+        template<typename T, typename... Args>
+        inline T* emplace_child(Args&&... args) {
+            /** Construct a child element in place */
+            T* child = this->get_pool().make<T>(std::forward<Args>(args)...);
+            this->children.push_back(child);
+            return child;
         }
 
         inline virtual float get_width() {
-            if (attr.find("width") != attr.end())
-                return std::stof(attr["width"]);
-            else
-                return NAN;
+            return attr.get_float(Attr::WIDTH);
         }
 
         inline virtual float get_height() {
-            if (attr.find("height") != attr.end())
-                return std::stof(attr["height"]);
-            else
-                return NAN;
+            return attr.get_float(Attr::HEIGHT);
         }
 
-        virtual std::string to_string();
-        std::map < std::string, std::string > attr;
+        virtual void write(Writer& out);
+        void write_parallel(Writer& out, size_t min_cost);
+        std::string to_string();
+        void hoist_styles(size_t min_uses = 2);
+        Attributes attr;
         std::string content;
-        std::vector<std::shared_ptr<Element>> children;
+        std::vector<Element*> children; /*< Owned by the tree's NodePool */
 
     protected:
+        friend class NodePool;
+
+        struct Piece {
+            std::string literal;      /*< Markup written as-is... */
+            Element* node = nullptr;  /*< ...or a subtree serialized as a unit */
+            size_t cost = 0;
+        };
+
+        void split(std::vector<Piece>& pieces, size_t min_cost, const NumberFormat& format);
+
+        inline virtual Element* clone(NodePool& nodes) const {
+            /** Deep copy this element into another pool */
+            return nodes.make<Element>(*this);
+        }
+
+        inline NodePool& get_pool() {
+            /** Return the pool children of this element should be allocated in */
+            if (!this->pool) {
+                this->owned_pool.reset(new NodePool());
+                this->pool = this->owned_pool.get();
+            }
+
+            return this->pool->resolve();
+        }
+
         std::string tag;
-    };
 
-    template<>
-    inline Element& Element::set_attr(std::string key, const char * value) {
-        this->attr[key] = value;
-        return *this;
-    }
+    private:
+        std::unique_ptr<NodePool> owned_pool; /*< Set if this element is the root of a tree */
+        NodePool* pool = nullptr;
+    };
 
-    template<>
-    inline Element& Element::set_attr(std::string key, const std::string value) {
-        this->attr[key] = value;
-        return *this;
+    template<typename T, typename... Args>
+    inline T* NodePool::make(Args&&... args) {
+        /** Construct a node inside this pool, taking over any nodes it owns */
+        const size_t stride = round_up(sizeof(Header)) + round_up(sizeof(T));
+        Header* header = (Header*)this->allocate(stride);
+        header->node = nullptr; // In case the constructor throws
+        header->stride = stride;
+
+        T* node = new ((char*)header + round_up(sizeof(Header))) T(std::forward<Args>(args)...);
+        header->node = node;
+
+        if (node->owned_pool)
+            this->absorb(std::move(node->owned_pool));
+        node->pool = this;
+        return node;
     }
 
     class SVG : public Element {
     public:
-        SVG(std::map < std::string, std::string > _attr =
-        { { "xmlns", "http://www.w3.org/2000/svg" } }
-        ) : Element("svg", _attr) {};
+        SVG() : Element("svg") {
+            set_attr(Attr::XMLNS, "http://www.w3.org/2000/svg");
+        };
+
+    protected:
+        inline Element* clone(NodePool& nodes) const override {
+            return nodes.make<SVG>(*this);
+        }
     };
 
+    /** A path made of straight line segments
+     *
+     *  Vertices are kept in a flat coordinate buffer and the "d"
+     *  attribute is only formatted when the path is written out.
+     */
     class Path : public Element {
     public:
-        Path() : Element("path", {}) {};
+        Path() : Element("path") {};
 
-        template<typename T>
-        inline void start(T x, T y) {
+        inline void start(float x, float y) {
             /** Start line at (x, y)
             *  This function overwrites the current path if it exists
             */
-            this->attr["d"] = "M " + std::to_string(x) + " " + std::to_string(y);
+            this->points.clear();
+            this->points.push_back(x);
+            this->points.push_back(y);
             this->x_start = x;
             this->y_start = y;
         }
 
-        template<typename T>
-        inline void line_to(T x, T y) {
+        inline void line_to(float x, float y) {
             /** Draw a line to (x, y)
             *  If line has not been initialized by setting a starting point,
             *  then start() will be called with (x, y) as arguments
             */
 
-            if (this->attr.find("d") == this->attr.end())
+            if (this->points.empty())
                 start(x, y);
-            else
-                this->attr["d"] += " L " + std::to_string(x) +
-                " " + std::to_string(y);
+            else {
+                this->points.push_back(x);
+                this->points.push_back(y);
+            }
         }
 
         inline void line_to(std::pair<float, float> coord) {
@@ -121,7 +620,22 @@ namespace SVG {
             this->line_to(x_start, y_start);
         }
 
+        inline void reserve(size_t vertices) {
+            /** Preallocate space for a number of vertices */
+            this->points.reserve(2 * vertices);
+        }
+
+        inline size_t size() const { return this->points.size() / 2; }
+
+        void write(Writer& out) override;
+
+    protected:
+        inline Element* clone(NodePool& nodes) const override {
+            return nodes.make<Path>(*this);
+        }
+
     private:
+        std::vector<float> points; /*< Interleaved x, y coordinates */
         float x_start;
         float y_start;
     };
@@ -131,35 +645,57 @@ namespace SVG {
         Text() { tag = "text"; };
         Text(float x, float y, std::string _content) {
             tag = "text";
-            set_attr("x", std::to_string(x));
-            set_attr("y", std::to_string(y));
+            set_attr(Attr::X, x);
+            set_attr(Attr::Y, y);
             content = _content;
         }
         Text(std::pair<float, float> xy, std::string _content) :
             Text(xy.first, xy.second, _content) {};
 
-        std::string to_string() override;
+        void write(Writer& out) override;
+
+    protected:
+        inline Element* clone(NodePool& nodes) const override {
+            return nodes.make<Text>(*this);
+        }
     };
 
     class Group : public Element {
     public:
-        Group() : Element("g", {}) {};
+        Group() : Element("g") {};
+
+    protected:
+        inline Element* clone(NodePool& nodes) const override {
+            return nodes.make<Group>(*this);
+        }
+    };
+
+    /** A <style> element holding CSS rules */
+    class Style : public Element {
+    public:
+        Style() : Element("style") {};
+        Style(std::string css) : Element("style") { content = css; };
+
+        void write(Writer& out) override;
+
+    protected:
+        inline Element* clone(NodePool& nodes) const override {
+            return nodes.make<Style>(*this);
+        }
     };
 
     class Line : public Element {
     public:
         Line() {};
-        Line(float x1, float x2, float y1, float y2) : Element("line", {
-            { "x1", std::to_string(x1) },
-            { "x2", std::to_string(x2) },
-            { "y1", std::to_string(y1) },
-            { "y2", std::to_string(y2) }
-        }) {};
-
-        inline float x1() { return std::stof(this->attr["x1"]); }
-        inline float x2() { return std::stof(this->attr["x2"]); }
-        inline float y1() { return std::stof(this->attr["y1"]); }
-        inline float y2() { return std::stof(this->attr["y2"]); }
+        Line(float x1, float x2, float y1, float y2) : Element("line") {
+            set_attr(Attr::X1, x1).set_attr(Attr::X2, x2)
+                .set_attr(Attr::Y1, y1).set_attr(Attr::Y2, y2);
+        };
+
+        inline float x1() { return this->attr.get_float(Attr::X1); }
+        inline float x2() { return this->attr.get_float(Attr::X2); }
+        inline float y1() { return this->attr.get_float(Attr::Y1); }
+        inline float y2() { return this->attr.get_float(Attr::Y2); }
 
         inline float get_width() override;
         inline float get_height() override;
@@ -167,6 +703,11 @@ namespace SVG {
         inline float get_slope();
 
         std::pair<float, float> along(float percent);
+
+    protected:
+        inline Element* clone(NodePool& nodes) const override {
+            return nodes.make<Line>(*this);
+        }
     };
 
     class Rect : public Element {
@@ -174,32 +715,181 @@ namespace SVG {
         Rect() {};
         Rect(
             float x, float y, float width, float height) :
-            Element("rect", {
-                { "x", std::to_string(x) },
-                { "y", std::to_string(y) },
-                { "width", std::to_string(width) },
-                { "height", std::to_string(height) }
-            }) {};
+            Element("rect") {
+            set_attr(Attr::X, x).set_attr(Attr::Y, y)
+                .set_attr(Attr::WIDTH, width).set_attr(Attr::HEIGHT, height);
+        };
+
+    protected:
+        inline Element* clone(NodePool& nodes) const override {
+            return nodes.make<Rect>(*this);
+        }
     };
 
     class Circle : public Element {
     public:
         Circle() {};
 
-        Circle(float cx, float cy, float radius) :
-            Element("circle", {
-                { "cx", std::to_string(cx) },
-                { "cy", std::to_string(cy) },
-                { "r", std::to_string(radius) }
-            }) {
+        Circle(float cx, float cy, float radius) : Element("circle") {
+            set_attr(Attr::CX, cx).set_attr(Attr::CY, cy).set_attr(Attr::R, radius);
         };
 
         Circle(std::pair<float, float> xy, float radius) : Circle(xy.first, xy.second, radius) {
         };
+
+    protected:
+        inline Element* clone(NodePool& nodes) const override {
+            return nodes.make<Circle>(*this);
+        }
+    };
+
+    class Image : public Element {
+    public:
+        Image() {};
+
+        Image(float x, float y, float width, float height, const std::string& href) :
+            Element("image") {
+            set_attr(Attr::X, x).set_attr(Attr::Y, y)
+                .set_attr(Attr::WIDTH, width).set_attr(Attr::HEIGHT, height)
+                .set_attr(Attr::PRESERVE_ASPECT_RATIO, "none")
+                .set_attr(Attr::HREF, href);
+        };
+
+    protected:
+        inline Element* clone(NodePool& nodes) const override {
+            return nodes.make<Image>(*this);
+        }
+    };
+
+    /** Many circles drawn as a single <path> made of arc subpaths
+     *
+     *  Like Path, the circles are kept in a flat buffer and only
+     *  formatted when written out.
+     */
+    class CirclePath : public Element {
+    public:
+        CirclePath() : Element("path") {};
+
+        inline void add(float cx, float cy, float radius) {
+            this->circles.push_back(cx);
+            this->circles.push_back(cy);
+            this->circles.push_back(radius);
+        }
+
+        inline void add(std::pair<float, float> xy, float radius) {
+            this->add(xy.first, xy.second, radius);
+        }
+
+        inline void append(const CirclePath& other) {
+            this->circles.insert(this->circles.end(), other.circles.begin(), other.circles.end());
+        }
+
+        inline void reserve(size_t n) { this->circles.reserve(3 * n); }
+        inline size_t size() const { return this->circles.size() / 3; }
+
+        void write(Writer& out) override;
+
+    protected:
+        inline Element* clone(NodePool& nodes) const override {
+            return nodes.make<CirclePath>(*this);
+        }
+
+    private:
+        std::vector<float> circles; /*< Interleaved cx, cy, radius */
+    };
+
+    /** An element whose children are generated while it is written, so
+     *  they never have to be held in memory all at once
+     *
+     *  generate() writes the children's markup, one per line and prefixed
+     *  with a tab as Element::write() does. If the tag is empty,
+     *  generate() writes all of the element's markup instead.
+     */
+    class Stream : public Element {
+    public:
+        typedef std::function<void(Writer&)> Generator;
+
+        Stream(const std::string& _tag, Generator _generate) :
+            Element(_tag), generate(_generate) {};
+
+        void write(Writer& out) override;
+
+    protected:
+        inline Element* clone(NodePool& nodes) const override {
+            return nodes.make<Stream>(*this);
+        }
+
+    private:
+        Generator generate;
     };
 }
 
 namespace Graphs {
+    std::string to_string(float number, size_t n = 1);
+
+    /** Upper limit on the threads used by parallel_for(), or 0 for one
+     *  per hardware thread. Atomic, since it may be changed while other
+     *  threads are writing plots.
+     */
+    inline std::atomic<size_t> max_threads(0);
+
+    inline size_t parallel_chunks(size_t n, size_t min_chunk) {
+        /** Number of chunks parallel_for() should split n items into so that
+         *  every chunk holds at least min_chunk items and no more chunks
+         *  than threads are used
+         */
+        size_t threads = max_threads.load();
+        if (!threads)
+            threads = std::max((size_t)std::thread::hardware_concurrency(), (size_t)1);
+        return std::max(std::min(threads, n / std::max(min_chunk, (size_t)1)), (size_t)1);
+    }
+
+    template<typename F>
+    inline void parallel_for(size_t n, size_t chunks, F func) {
+        /** Split [0, n) into contiguous chunks and call func(begin, end, chunk)
+         *  for each one, running all but the last chunk on their own threads.
+         *  The first exception thrown by any chunk is rethrown once all have finished.
+         */
+        chunks = std::max(std::min(chunks, n), (size_t)1);
+        if (chunks == 1) {
+            func((size_t)0, n, (size_t)0);
+            return;
+        }
+
+        std::vector<std::thread> workers;
+        std::vector<std::exception_ptr> errors(chunks);
+        auto run = [&](size_t chunk) {
+            try {
+                func(n * chunk / chunks, n * (chunk + 1) / chunks, chunk);
+            }
+            catch (...) {
+                errors[chunk] = std::current_exception();
+            }
+        };
+
+        workers.reserve(chunks - 1);
+        for (size_t i = 0; i + 1 < chunks; i++)
+            workers.emplace_back(run, i);
+        run(chunks - 1);
+
+        for (auto& worker : workers) worker.join();
+        for (auto& error : errors)
+            if (error) std::rethrow_exception(error);
+    }
+
+    template<typename F>
+    inline void parallel_tasks(size_t n, size_t threads, F func) {
+        /** Call func(i) for every i in [0, n) using up to threads threads.
+         *  Tasks are handed out one at a time as threads become free, so
+         *  tasks of uneven size still keep every thread busy.
+         */
+        std::atomic<size_t> next(0);
+        parallel_for(std::min(threads, n), threads, [&](size_t, size_t, size_t) {
+            for (size_t i; (i = next++) < n;)
+                func(i);
+        });
+    }
+
     const std::vector<std::string> QUALITATIVE_COLORS = {
         "#a6cee3", "#1f78b4", "#b2df8a", "#33a02c",
         "#fb9a99", "#e31a1c", "#fdbf6f", "#ff7f00",
@@ -219,6 +909,320 @@ namespace Graphs {
     const GraphOptions DEFAULT_GRAPH_LEGEND = { 800, 400, 75, 200, 100, 50 };
     const GraphOptions POLAR_GRAPH_LEGEND = { 800, 600, 50, 200, 50, 50 };
 
+    /** How Graph::make_point() draws each point */
+    enum class PointMode {
+        CIRCLES, /*< One <circle> element per point */
+        PATH,    /*< All points of a dataset batched into one <path> */
+        BINNED   /*< One <rect> per occupied grid cell, shaded by point count */
+    };
+
+    /** How Graph::make_line() thins out vertices before drawing them */
+    enum class Downsampling {
+        NONE, /*< One vertex per data point */
+        M4,   /*< First, last, min and max vertex of each pixel column */
+        LTTB  /*< Largest-Triangle-Three-Buckets, two vertices per pixel column */
+    };
+
+    typedef std::vector<std::pair<float, float>> Polyline;
+
+    Polyline downsample_m4(const Polyline& points);
+    Polyline downsample_lttb(const Polyline& points, size_t threshold);
+
+    /** A pointer which steps over stride values at a time */
+    template<typename V>
+    struct StridedPointer {
+        const V* ptr;
+        size_t stride;
+
+        inline const V& operator[](size_t i) const { return ptr[i * stride]; }
+        inline StridedPointer<V> operator+(size_t n) const { return { ptr + n * stride, stride }; }
+    };
+
+    /** A non-owning view of n values spaced stride elements apart, e.g.
+     *  one field of an array of records. The caller keeps the buffer
+     *  alive and unchanged for as long as the view is used.
+     */
+    template<typename V>
+    class Column {
+    public:
+        typedef V value_type;
+
+        Column() {};
+        Column(const V* values, size_t n, size_t stride = 1) :
+            ptr(values), n(n), stride(stride) {};
+        explicit Column(const std::vector<V>& values) : Column(values.data(), values.size()) {};
+        Column(const std::vector<V>&&) = delete; // Would dangle once the temporary is gone
+
+        inline StridedPointer<V> data() const { return { ptr, stride }; }
+        inline size_t size() const { return n; }
+        inline bool empty() const { return n == 0; }
+        inline const V& operator[](size_t i) const { return ptr[i * stride]; }
+
+        inline const V& at(size_t i) const {
+            if (i >= n) throw std::out_of_range("Column index out of range.");
+            return (*this)[i];
+        }
+
+    private:
+        const V* ptr = nullptr;
+        size_t n = 0;
+        size_t stride = 1;
+    };
+
+    /** Summary of a column of values, gathered in a single pass
+     *  NaNs are counted but otherwise ignored
+     */
+    struct ColumnStats {
+        long double min = NAN;
+        long double max = NAN;
+        long double sum = 0;
+        size_t count = 0;     /*< Number of values which aren't NaN */
+        size_t nan_count = 0;
+
+        inline void merge(const ColumnStats& other) {
+            if (other.count) {
+                min = count ? std::min(min, other.min) : other.min;
+                max = count ? std::max(max, other.max) : other.max;
+            }
+
+            sum += other.sum;
+            count += other.count;
+            nan_count += other.nan_count;
+        }
+
+        inline long double mean() const { return count ? sum / count : NAN; }
+    };
+
+    template<typename Ptr>
+    inline ColumnStats column_stats(Ptr values, size_t n) {
+        /** Compute min, max, sum and counts together, splitting large
+         *  columns across threads
+         *
+         *  values: A plain or strided pointer
+         */
+        typedef typename std::decay<decltype(values[0])>::type V;
+        const size_t chunks = parallel_chunks(n, 1 << 20);
+        std::vector<ColumnStats> partial(chunks);
+
+        parallel_for(n, chunks, [&](size_t begin, size_t end, size_t chunk) {
+            ColumnStats& stats = partial[chunk];
+
+            // Compare in the column's own type and sum in at least double
+            // precision, with no branches so the loop can be vectorized
+            V min = std::numeric_limits<V>::has_infinity ? std::numeric_limits<V>::infinity() : std::numeric_limits<V>::max(),
+                max = std::numeric_limits<V>::has_infinity ? -std::numeric_limits<V>::infinity() : std::numeric_limits<V>::lowest();
+            decltype(V() + 0.0) sum = 0;
+            size_t nans = 0;
+
+            for (size_t i = begin; i < end; i++) {
+                V value = values[i];
+                bool nan = value != value;
+                nans += nan;
+                min = value < min ? value : min;
+                max = value > max ? value : max;
+                sum += nan ? 0 : value;
+            }
+
+            stats.nan_count = nans;
+            stats.count = end - begin - nans;
+            stats.sum = sum;
+            if (stats.count) {
+                stats.min = min;
+                stats.max = max;
+            }
+        });
+
+        ColumnStats ret;
+        for (auto& stats : partial)
+            ret.merge(stats);
+        return ret;
+    }
+
+    /** Rules for choosing the number of histogram bins from the data */
+    enum class Binning {
+        STURGES,          /*< log2(n) + 1 bins */
+        FREEDMAN_DIACONIS /*< Bins 2 * IQR / cbrt(n) wide */
+    };
+
+    std::vector<long double> uniform_edges(long double min, long double max, size_t bins);
+    std::vector<long double> width_edges(long double min, long double max, long double width);
+
+    template<typename Ptr>
+    inline std::vector<size_t> bin_counts(Ptr values, size_t n, const std::vector<long double>& edges) {
+        /** Count the values in each bin [edges[i], edges[i + 1]), with the
+         *  last bin also including its upper edge. NaNs and values outside
+         *  the edges aren't counted.
+         *
+         *  Every thread counts into its own bins, which are added up at the
+         *  end. For evenly spaced edges, bin indices are computed a block at
+         *  a time with no branches so the loop can be vectorized, then
+         *  corrected by comparing against the neighbouring edges.
+         */
+        if (edges.size() < 2) return {};
+        const size_t bins = edges.size() - 1;
+        if (bins >= (size_t)std::numeric_limits<int>::max())
+            throw std::runtime_error("Too many histogram bins");
+
+        const std::vector<double> e(edges.begin(), edges.end());
+        const double lo = e.front(), hi = e.back(), width = (hi - lo) / bins;
+        bool uniform = width > 0;
+        for (size_t i = 0; uniform && i <= bins; i++)
+            uniform = fabs(e[i] - (lo + i * width)) < width / 4;
+
+        // Each chunk keeps four interleaved sets of counts, so runs of
+        // values in the same bin don't wait on each other's increments.
+        // The extra bin in each set collects values which aren't counted.
+        const size_t chunks = parallel_chunks(n, 1 << 20), stride = bins + 1;
+        std::vector<std::vector<size_t>> partial(chunks);
+
+        parallel_for(n, chunks, [&](size_t begin, size_t end, size_t chunk) {
+            std::vector<size_t>& counts = partial[chunk];
+            counts.assign(4 * stride, 0);
+            const double scale = uniform ? 1 / width : 0, last = (double)(bins - 1), skip = (double)bins;
+            const int n_bins = (int)bins;
+            int index[256];
+
+            for (size_t block = begin; block < end; block += 256) {
+                const size_t m = std::min(end - block, (size_t)256);
+                if (uniform) {
+                    for (size_t j = 0; j < m; j++) {
+                        double v = (double)values[block + j], t = (v - lo) * scale;
+                        index[j] = (int)(v >= lo && v <= hi ? std::min(t, last) : skip);
+                    }
+                }
+
+                for (size_t j = 0; j < m; j++) {
+                    double v = (double)values[block + j];
+                    int k;
+                    if (uniform) {
+                        k = index[j];
+                        if (k < n_bins) {
+                            k -= v < e[k];
+                            k += (v >= e[k + 1]) & (k != n_bins - 1);
+                        }
+                    }
+                    else if (v >= lo && v <= hi)
+                        k = std::min((int)(std::upper_bound(e.begin(), e.end(), v) - e.begin()) - 1, n_bins - 1);
+                    else
+                        k = n_bins;
+
+                    counts[(j & 3) * stride + k]++;
+                }
+            }
+        });
+
+        std::vector<size_t> ret(bins, 0);
+        for (auto& counts : partial)
+            for (size_t set = 0; set < 4; set++)
+                for (size_t i = 0; i < bins; i++)
+                    ret[i] += counts[set * stride + i];
+        return ret;
+    }
+
+    template<typename Ptr>
+    inline std::vector<long double> bin_edges(Ptr values, size_t n, size_t bins) {
+        /** Evenly spaced edges covering the values' range */
+        ColumnStats stats = column_stats(values, n);
+        if (!stats.count) return {};
+        if (stats.min == stats.max) {
+            stats.min -= 0.5;
+            stats.max += 0.5;
+        }
+
+        return uniform_edges(stats.min, stats.max, std::max(bins, (size_t)1));
+    }
+
+    template<typename Ptr>
+    inline std::vector<long double> bin_edges(Ptr values, size_t n, Binning rule) {
+        /** Evenly spaced edges covering the values' range, with the number
+         *  of bins chosen by rule
+         *
+         *  The quartiles used by Freedman-Diaconis are interpolated from a
+         *  fine histogram rather than found by sorting a copy of the data,
+         *  which is close enough for choosing a bin width.
+         */
+        ColumnStats stats = column_stats(values, n);
+        if (!stats.count) return {};
+
+        const size_t sturges = (size_t)ceil(log2((double)stats.count)) + 1;
+        if (stats.min == stats.max)
+            return bin_edges(values, n, (size_t)1);
+        if (rule == Binning::STURGES)
+            return uniform_edges(stats.min, stats.max, sturges);
+
+        const size_t fine = 1 << 16;
+        const std::vector<long double> fine_edges = uniform_edges(stats.min, stats.max, fine);
+        const std::vector<size_t> counts = bin_counts(values, n, fine_edges);
+        auto quantile = [&](double q) {
+            const double target = q * stats.count;
+            double seen = 0;
+            for (size_t i = 0; i < fine; i++) {
+                if (counts[i] && seen + counts[i] >= target)
+                    return fine_edges[i] + (fine_edges[i + 1] - fine_edges[i]) * ((target - seen) / counts[i]);
+                seen += counts[i];
+            }
+            return fine_edges.back();
+        };
+
+        const long double iqr = quantile(0.75) - quantile(0.25),
+            width = 2 * iqr / cbrt((double)stats.count);
+        if (!(width > 0)) // Over half the values are the same
+            return uniform_edges(stats.min, stats.max, sturges);
+
+        const long double bins = ceil((stats.max - stats.min) / width);
+        return uniform_edges(stats.min, stats.max, (size_t)std::min(bins, (long double)(1 << 20)));
+    }
+
+    /** Cached statistics for a column which is usually appended to
+     *
+     *  Values added since the last call are scanned and merged in. A
+     *  column that shrank or moved to another buffer is rescanned from
+     *  scratch. Changing values in place, or assigning as many values
+     *  into the same buffer, requires an explicit invalidate(). The cache
+     *  is locked, so datasets can be shared between threads.
+     */
+    class StatsCache {
+    public:
+        StatsCache() {};
+        StatsCache(const StatsCache&) {}; // Copies of a dataset scan their own values
+        StatsCache& operator=(const StatsCache&) {
+            this->invalidate();
+            return *this;
+        }
+
+        template<typename Values>
+        inline ColumnStats get(const Values& values) {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            const void* buffer = values.size() ? (const void*)&values[0] : nullptr;
+            if (buffer != this->buffer || values.size() < this->covered) {
+                this->stats = ColumnStats();
+                this->buffer = buffer;
+                this->covered = 0;
+            }
+
+            if (this->covered < values.size()) {
+                this->stats.merge(column_stats(values.data() + this->covered,
+                    values.size() - this->covered));
+                this->covered = values.size();
+            }
+
+            return this->stats;
+        }
+
+        inline void invalidate() {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stats = ColumnStats();
+            this->buffer = nullptr;
+            this->covered = 0;
+        }
+
+    private:
+        std::mutex mutex;
+        ColumnStats stats;
+        const void* buffer = nullptr; /*< Where the values scanned were */
+        size_t covered = 0;           /*< Number of leading values included in stats */
+    };
+
     /** Abstract base class for Dataset* */
     class DatasetBase {
     public:
@@ -231,49 +1235,117 @@ namespace Graphs {
         virtual std::vector<std::string> y_labels(const size_t labels=5);
     };
 
-    template <class T>
+    /** A series of (x, y) values
+     *
+     *  T: Type of the x values
+     *  V: Type used to store the y values, double by default. float halves
+     *     the memory used, at the cost of precision.
+     */
+    template <class T, class V = double>
     struct Dataset: public DatasetBase {
+        typedef T x_type;
+        typedef V value_type;
+
         Dataset() {};
-        Dataset(const std::vector<T> x, const std::vector<long double> y) :
+        Dataset(const std::vector<T>& x, const std::vector<V>& y) :
             x_values(x), y_values(y) {
             if (x.size() != y.size()) {
                 throw std::runtime_error("Number of labels does not match number of heights.");
             }
         };
 
+        template<typename X, typename Y>
+        Dataset(const std::vector<X>& x, const std::vector<Y>& y) :
+            x_values(x.begin(), x.end()), y_values(y.begin(), y.end()) {
+            /** Convert values stored in another type */
+            if (x.size() != y.size()) {
+                throw std::runtime_error("Number of labels does not match number of heights.");
+            }
+        };
+
         inline const size_t size() override { return x_values.size(); }
         inline long double x_min() override { return NAN; }
         inline long double x_max() override { return NAN; }
         inline long double y_min() override {
-            /** Return the lowest y value or 0 */
-            long double min = *(std::min_element(y_values.begin(), y_values.end()));
-            if (min > 0) return 0;
+            /** Return the lowest y value, or 0 if it's positive or there are no values */
+            long double min = y_stats().min;
+            if (min > 0 || std::isnan(min)) return 0;
             return min;
         }
 
         inline long double y_max() override {
             /** Return the highest y value */
-            return *(std::max_element(y_values.begin(), y_values.end()));
+            return y_stats().max;
+        }
+
+        inline ColumnStats y_stats() const { return y_cache.get(y_values); }
+
+        inline void invalidate() {
+            /** Discard cached statistics after values were changed in place */
+            x_cache.invalidate();
+            y_cache.invalidate();
         }
 
         std::string name = "";
         std::vector<T> x_values;
-        std::vector<long double> y_values;
+        std::vector<V> y_values;
+
+    protected:
+        mutable StatsCache x_cache;
+        mutable StatsCache y_cache;
     };
 
-    /** A collection of Dataset */
+    /** A collection of Dataset
+     *
+     *  Datasets are held by shared pointer, so collections can be built
+     *  and copied without copying any data. Lvalues added to a collection
+     *  are borrowed and must outlive it, while rvalues are moved in and
+     *  owned by the collection.
+     */
     template<class T>
     class DatasetCollection: public DatasetBase {
     public:
         DatasetCollection() {};
-        std::vector<T> datasets;
+        std::vector<std::shared_ptr<T>> datasets;
+
+        inline DatasetCollection<T>& add(T& data) {
+            /** Borrow a dataset owned by the caller */
+            this->datasets.push_back(std::shared_ptr<T>(&data, [](T*) {}));
+            return *this;
+        }
+
+        inline DatasetCollection<T>& add(T&& data) {
+            this->datasets.push_back(std::make_shared<T>(std::move(data)));
+            return *this;
+        }
 
-        inline DatasetCollection<T>& operator+ (T& data) {
-            this->datasets.push_back(data);
+        inline DatasetCollection<T>& add(std::shared_ptr<T> data) {
+            this->datasets.push_back(std::move(data));
             return *this;
         }
 
-        std::vector<std::string> x_labels(size_t max_labels = 20) override;
+        inline DatasetCollection<T>& operator+ (T& data) & { return this->add(data); }
+        inline DatasetCollection<T>& operator+ (T&& data) & { return this->add(std::move(data)); }
+
+        inline DatasetCollection<T> operator+ (T& data) && {
+            /** Extend a temporary collection, e.g. the result of a + b in a + b + c */
+            this->add(data);
+            return std::move(*this);
+        }
+
+        inline DatasetCollection<T> operator+ (T&& data) && {
+            this->add(std::move(data));
+            return std::move(*this);
+        }
+
+        inline std::vector<std::string> x_labels(size_t max_labels = 20) override {
+            // Assumes all categorical datasets have the same labels
+            if constexpr (std::is_same<typename T::x_type, std::string>::value)
+                return this->datasets.front()->x_labels(max_labels);
+            else
+                return DatasetBase::x_labels(max_labels);
+        }
+
         inline std::vector<std::string> y_labels(const size_t i, const size_t labels) {
             /** Create axis labels for elements at index i */
             std::vector<std::string> ret_labels;
@@ -290,16 +1362,38 @@ namespace Graphs {
         inline const size_t size() override { 
             if (datasets.empty())
                 return 0;
-            return datasets.begin()->size();
+            return datasets.front()->size();
+        }
+
+        inline long double x_min() override {
+            /** Return the smallest x value in the collection of data */
+            long double min = NAN;
+            for (auto it = datasets.begin(); it != datasets.end(); ++it) {
+                long double value = (*it)->x_min();
+                if (isnan(min) || value < min) min = value;
+            }
+
+            return min;
+        }
+
+        inline long double x_max() override {
+            /** Return the largest x value in the collection of data */
+            long double max = NAN;
+            for (auto it = datasets.begin(); it != datasets.end(); ++it) {
+                long double value = (*it)->x_max();
+                if (isnan(max) || value > max) max = value;
+            }
+
+            return max;
         }
 
-        inline long double x_min() override { return NAN; }
-        inline long double x_max() override { return NAN; }
         inline long double y_min() override {
             /** Return the lowest y value in the collection of data */
             long double min = 0; // Always set 0 as the lowest unless there's a lower number
-            for (auto it = datasets.begin(); it != datasets.end(); ++it)
-                if (isnan(min) || it->y_min() < min) min = it->y_min();
+            for (auto it = datasets.begin(); it != datasets.end(); ++it) {
+                long double value = (*it)->y_min();
+                if (isnan(min) || value < min) min = value;
+            }
 
             return min;
         }
@@ -307,8 +1401,10 @@ namespace Graphs {
         inline long double y_max() override {
             /** Return the largest y value in the collection of data */
             long double max = NAN;
-            for (auto it = datasets.begin(); it != datasets.end(); ++it)
-                if (isnan(max) || it->y_max() > max) max = it->y_max();
+            for (auto it = datasets.begin(); it != datasets.end(); ++it) {
+                long double value = (*it)->y_max();
+                if (isnan(max) || value > max) max = value;
+            }
 
             return max;
         }
@@ -317,7 +1413,7 @@ namespace Graphs {
             /** Get the smallest value for items with index i */
             long double min = 0; // Always set 0 as lowest unless there's a lower number
             for (auto it = datasets.begin(); it != datasets.end(); ++it)
-                if (isnan(min) || it->y_values.at(i) < min) min = it->y_values.at(i);
+                if (isnan(min) || (*it)->y_values.at(i) < min) min = (*it)->y_values.at(i);
             return min;
         }
 
@@ -325,7 +1421,7 @@ namespace Graphs {
             /** Get the largest value for items with index i */
             long double max = 0; // Always set 0 as lowest unless there's a lower number
             for (auto it = datasets.begin(); it != datasets.end(); ++it)
-                if (isnan(max) || it->y_values.at(i) > max) max = it->y_values.at(i);
+                if (isnan(max) || (*it)->y_values.at(i) > max) max = (*it)->y_values.at(i);
             return max;
         }
 
@@ -343,67 +1439,270 @@ namespace Graphs {
             return this->fill_colors;
         }
 
-        inline std::vector<std::string> get_stroke() {
-            /** Use fill colors if stroke colors not set */
-            if (this->stroke_colors.empty())
-                return this->get_fill();
-            return this->stroke_colors;
+        inline std::vector<std::string> get_stroke() {
+            /** Use fill colors if stroke colors not set */
+            if (this->stroke_colors.empty())
+                return this->get_fill();
+            return this->stroke_colors;
+        }
+
+    private:
+        inline void set_colors(
+            std::vector<std::string>& target,
+            const std::vector<std::string>& colors) {
+            auto fill_color = colors.begin();
+            while (target.size() < this->datasets.size()) {
+                target.push_back(*fill_color);
+                fill_color++;
+
+                if (fill_color == colors.end())
+                    fill_color = colors.begin();
+            }
+        }
+
+        std::vector<std::string> fill_colors = {};
+        std::vector<std::string> stroke_colors = {};
+    };
+
+    /** Data used to plot bar plots, histograms, etc. */
+    template<class V = double>
+    class BasicCategoricalData : public Dataset<std::string, V> {
+    public:
+        using Dataset<std::string, V>::Dataset;
+        using Dataset<std::string, V>::size;
+
+
+        inline std::vector<std::string> x_labels(size_t max_labels=20) override { return this->x_values; }
+    };
+
+    template<class V = double>
+    class BasicNumericData : public Dataset<V, V> {
+    public:
+        using Dataset<V, V>::Dataset;
+        using Dataset<V, V>::size;
+
+        BasicNumericData(const std::vector<V>& x, const std::vector<V>& y,
+            const std::vector<V>& z) : Dataset<V, V>(x, y), z_values(z) {
+            if (y.size() != z.size())
+                throw std::runtime_error("y and z values have different lengths");
+        }
+
+        template<typename X, typename Y, typename Z>
+        BasicNumericData(const std::vector<X>& x, const std::vector<Y>& y,
+            const std::vector<Z>& z) : Dataset<V, V>(x, y), z_values(z.begin(), z.end()) {
+            if (y.size() != z.size())
+                throw std::runtime_error("y and z values have different lengths");
+        }
+
+
+        inline long double x_min() override {
+            /** Return the lowest x value */
+            return x_stats().min;
+        }
+
+        inline long double x_max() override {
+            /** Return the highest x value */
+            return x_stats().max;
+        }
+
+        inline ColumnStats x_stats() const { return this->x_cache.get(this->x_values); }
+
+        std::vector<V> z_values = {};
+    };
+
+    typedef BasicCategoricalData<> CategoricalData;
+    typedef BasicNumericData<> NumericData;
+
+    CategoricalData histogram(const std::vector<long double>& edges, const std::vector<size_t>& counts);
+
+    template<typename Ptr>
+    inline CategoricalData histogram(Ptr values, size_t n, const std::vector<long double>& edges) {
+        /** Bin values into bar-ready data labelled with each bin's edges */
+        return histogram(edges, bin_counts(values, n, edges));
+    }
+
+    template<typename Ptr>
+    inline CategoricalData histogram(Ptr values, size_t n, size_t bins) {
+        return histogram(values, n, bin_edges(values, n, bins));
+    }
+
+    template<typename Ptr>
+    inline CategoricalData histogram(Ptr values, size_t n, Binning rule = Binning::STURGES) {
+        return histogram(values, n, bin_edges(values, n, rule));
+    }
+
+    /** A Dataset over columns owned by the caller, so large buffers can
+     *  be plotted without being copied. Can be used wherever the
+     *  equivalent Dataset is, except for Graph::append().
+     */
+    template <class T, class V = double>
+    struct DatasetView : public DatasetBase {
+        typedef T x_type;
+        typedef V value_type;
+
+        DatasetView() {};
+        DatasetView(const Column<T>& x, const Column<V>& y) : x_values(x), y_values(y) {
+            if (x.size() != y.size()) {
+                throw std::runtime_error("Number of labels does not match number of heights.");
+            }
+        };
+
+        inline const size_t size() override { return x_values.size(); }
+        inline long double x_min() override { return NAN; }
+        inline long double x_max() override { return NAN; }
+        inline long double y_min() override {
+            /** Return the lowest y value, or 0 if it's positive or there are no values */
+            long double min = y_stats().min;
+            if (min > 0 || std::isnan(min)) return 0;
+            return min;
+        }
+
+        inline long double y_max() override {
+            /** Return the highest y value */
+            return y_stats().max;
         }
 
-    private:
-        inline void set_colors(
-            std::vector<std::string>& target,
-            const std::vector<std::string>& colors) {
-            auto fill_color = colors.begin();
-            while (target.size() < this->datasets.size()) {
-                target.push_back(*fill_color);
-                fill_color++;
+        inline ColumnStats y_stats() const { return y_cache.get(y_values); }
 
-                if (fill_color == colors.end())
-                    fill_color = colors.begin();
-            }
+        inline void invalidate() {
+            /** Discard cached statistics after the underlying buffers changed */
+            x_cache.invalidate();
+            y_cache.invalidate();
         }
 
-        std::vector<std::string> fill_colors = {};
-        std::vector<std::string> stroke_colors = {};
+        std::string name = "";
+        Column<T> x_values;
+        Column<V> y_values;
+
+    protected:
+        mutable StatsCache x_cache;
+        mutable StatsCache y_cache;
     };
 
-    /** Data used to plot bar plots, histograms, etc. */
-    class CategoricalData : public Dataset<std::string> {
+    template<class V = double>
+    class CategoricalView : public DatasetView<std::string, V> {
     public:
-        using Dataset<std::string>::Dataset;
-        using Dataset<std::string>::size;
+        using DatasetView<std::string, V>::DatasetView;
 
-        DatasetCollection<CategoricalData> operator+ (CategoricalData& other);
-        inline std::vector<std::string> x_labels(size_t max_labels=20) override { return this->x_values; }
+
+        inline std::vector<std::string> x_labels(size_t max_labels=20) override {
+            std::vector<std::string> labels;
+            for (size_t i = 0; i < this->x_values.size(); i++)
+                labels.push_back(this->x_values[i]);
+            return labels;
+        }
     };
 
-    class NumericData : public Dataset<long double> {
+    /** A view of numeric (x, y) values, with optional z values
+     *
+     *  V: Type of the y and z values
+     *  X: Type of the x values, e.g. int64_t for timestamps next to
+     *     double measurements
+     */
+    template<class V = double, class X = V>
+    class NumericView : public DatasetView<X, V> {
     public:
-        NumericData(
-            const std::vector<long double> x,
-            const std::vector<long double> y,
-            const std::vector<long double> z
-        );
+        using DatasetView<X, V>::DatasetView;
 
-        using Dataset<long double>::Dataset;
-        using Dataset<long double>::size;
+        NumericView(const Column<X>& x, const Column<V>& y, const Column<V>& z) :
+            DatasetView<X, V>(x, y), z_values(z) {
+            if (y.size() != z.size())
+                throw std::runtime_error("y and z values have different lengths");
+        }
 
-        DatasetCollection<NumericData> operator+ (NumericData& other);
 
-        inline long double x_min() override {
-            /** Return the lowest x value */
-            return *(std::min_element(x_values.begin(), x_values.end()));
+        inline long double x_min() override { return x_stats().min; }
+        inline long double x_max() override { return x_stats().max; }
+        inline ColumnStats x_stats() const { return this->x_cache.get(this->x_values); }
+
+        Column<V> z_values;
+    };
+
+    /** A dataset read one chunk at a time, for data too large to hold in
+     *  memory at once
+     *
+     *  The source is called with a visitor, which it must call with each
+     *  chunk in turn, producing the same chunks every time it is called.
+     *  Graph::plot() reads the data once to find the range of the axes,
+     *  then Graph::stream_point() and Graph::stream_line() read it again
+     *  while the plot is being written out, so only one chunk is held in
+     *  memory at a time.
+     */
+    template<class V = double, class X = V>
+    class ChunkedData : public DatasetBase {
+    public:
+        typedef X x_type;
+        typedef V value_type;
+        typedef std::function<void(NumericView<V, X>&)> Visitor;
+        typedef std::function<void(const Visitor&)> Source;
+
+        ChunkedData(Source _source) : source(_source) {};
+
+        inline void read(const Visitor& visit) const { this->source(visit); }
+
+        inline void scan() {
+            /** Gather statistics over every chunk, unless already done */
+            if (this->scanned) return;
+
+            ColumnStats x, y;
+            size_t n = 0;
+            this->read([&](NumericView<V, X>& chunk) {
+                x.merge(column_stats(chunk.x_values.data(), chunk.size()));
+                y.merge(column_stats(chunk.y_values.data(), chunk.size()));
+                n += chunk.size();
+            });
+
+            this->x_cache = x;
+            this->y_cache = y;
+            this->count = n;
+            this->scanned = true;
         }
 
-        inline long double x_max() override {
-            /** Return the highest x value */
-            return *(std::max_element(x_values.begin(), x_values.end()));
+        inline void invalidate() { this->scanned = false; }
+
+        inline const size_t size() override { this->scan(); return this->count; }
+        inline long double x_min() override { return this->x_stats().min; }
+        inline long double x_max() override { return this->x_stats().max; }
+        inline long double y_min() override {
+            /** Return the lowest y value, or 0 if it's positive or there are no values */
+            long double min = this->y_stats().min;
+            if (min > 0 || std::isnan(min)) return 0;
+            return min;
         }
 
-        std::vector<long double> z_values = {};
+        inline long double y_max() override { return this->y_stats().max; }
+        inline const ColumnStats& x_stats() { this->scan(); return this->x_cache; }
+        inline const ColumnStats& y_stats() { this->scan(); return this->y_cache; }
+
+        std::string name = "";
+
+    private:
+        Source source;
+        ColumnStats x_cache;
+        ColumnStats y_cache;
+        size_t count = 0;
+        bool scanned = false;
     };
 
+    template<class T>
+    struct is_collection : std::false_type {};
+
+    template<class T>
+    struct is_collection<DatasetCollection<T>> : std::true_type {};
+
+    /** Combine two datasets of the same type into a collection, borrowing
+     *  lvalues and moving rvalues in
+     */
+    template<class A, class B, class T = typename std::decay<A>::type,
+        typename std::enable_if<std::is_same<T, typename std::decay<B>::type>::value
+            && std::is_base_of<DatasetBase, T>::value && !is_collection<T>::value, int>::type = 0>
+    inline DatasetCollection<T> operator+ (A&& a, B&& b) {
+        DatasetCollection<T> ret;
+        ret.add(std::forward<A>(a));
+        ret.add(std::forward<B>(b));
+        return ret;
+    }
+
     /** Defines a mapping from the data space to the SVG coordinate space
      *  Having multiple data sets on the same plot involves adjusting the coordinate system
      */
@@ -427,8 +1726,21 @@ namespace Graphs {
             range_max = data.y_max();
         }
 
-        inline float map_x(float x);
-        inline float map_y(float x);
+        /** Bounding box of a batch of mapped points */
+        struct Extent {
+            float x_min = INFINITY, x_max = -INFINITY;
+            float y_min = INFINITY, y_max = -INFINITY;
+
+            inline void merge(const Extent& other) {
+                x_min = std::min(x_min, other.x_min);
+                x_max = std::max(x_max, other.x_max);
+                y_min = std::min(y_min, other.y_min);
+                y_max = std::max(y_max, other.y_max);
+            }
+        };
+
+        inline float map_x(double x);
+        inline float map_y(double x);
 
         template<typename T>
         inline std::pair<float, float> map(T x, T y) {
@@ -436,6 +1748,55 @@ namespace Graphs {
             return std::make_pair(ret_x, ret_y);
         };
 
+        template<typename X, typename Y>
+        inline Extent map_range(X x, Y y, size_t n, float* out_x, float* out_y) const {
+            /** Map n points into out_x and out_y and return their extent
+             *
+             *  x, y: Plain or strided pointers to the data
+             *
+             *  The scale factors are computed once, leaving a branch-free
+             *  multiply-add per coordinate which compilers vectorize.
+             *  Gives the same results as map_x() and map_y().
+             */
+            const double sx = x_scale(), sy = y_scale(),
+                dx = (double)domain_min, dy = (double)range_min;
+            float x_lo = INFINITY, x_hi = -INFINITY, y_lo = INFINITY, y_hi = -INFINITY;
+
+            for (size_t i = 0; i < n; i++) {
+                float px = (float)(((double)x[i] - dx) * sx + x1),
+                    py = (float)(y2 - ((double)y[i] - dy) * sy);
+                out_x[i] = px;
+                out_y[i] = py;
+
+                // Written as selects so NaNs are skipped and the loop still vectorizes
+                x_lo = px < x_lo ? px : x_lo;
+                x_hi = px > x_hi ? px : x_hi;
+                y_lo = py < y_lo ? py : y_lo;
+                y_hi = py > y_hi ? py : y_hi;
+            }
+
+            Extent ret;
+            ret.x_min = x_lo; ret.x_max = x_hi;
+            ret.y_min = y_lo; ret.y_max = y_hi;
+            return ret;
+        }
+
+        template<typename X, typename Y>
+        inline Extent map(X x, Y y, size_t n, float* out_x, float* out_y) const {
+            /** Like map_range(), split across threads for large inputs */
+            const size_t chunks = parallel_chunks(n, 1 << 16);
+            std::vector<Extent> extents(chunks);
+            parallel_for(n, chunks, [&](size_t begin, size_t end, size_t chunk) {
+                extents[chunk] = this->map_range(x + begin, y + begin, end - begin,
+                    out_x + begin, out_y + begin);
+            });
+
+            Extent ret;
+            for (auto& extent : extents)
+                ret.merge(extent);
+            return ret;
+        }
+
         inline std::pair<float, float> center() {
             /** Return the center of the drawing area */
             float x = x1 + ((x2 - x1) / 2);
@@ -446,6 +1807,16 @@ namespace Graphs {
         inline float get_height() { return y2 - y1; }
         inline float get_width() { return x2 - y1; }
 
+        inline double x_scale() const {
+            /** SVG units per unit of data along the x-axis */
+            return (x2 - x1) / (double)(domain_max - domain_min);
+        }
+
+        inline double y_scale() const {
+            /** SVG units per unit of data along the y-axis */
+            return (y2 - y1) / (double)(range_max - range_min);
+        }
+
         float x1;
         float x2;
         float y1;
@@ -458,13 +1829,13 @@ namespace Graphs {
     };
 
     template<class Data>
-    inline float CartesianCoordinates<Data>::map_x(float x) {
-        return (float)(x1 + (x2 - x1) * ((x - domain_min) / (domain_max - domain_min)));
+    inline float CartesianCoordinates<Data>::map_x(double x) {
+        return (float)((x - (double)domain_min) * x_scale() + x1);
     };
 
     template<class Data>
-    inline float CartesianCoordinates<Data>::map_y(float y) {
-        return (float)(y2 - (y2 - y1) * ((y - range_min) / (range_max - range_min)));
+    inline float CartesianCoordinates<Data>::map_y(double y) {
+        return (float)(y2 - (y - (double)range_min) * y_scale());
     };
 
     /** Defines a mapping from polar coordinates to the SVG coordinate space */
@@ -485,7 +1856,25 @@ namespace Graphs {
     class PlotBase {
     public:
         PlotBase(GraphOptions _options = DEFAULT_GRAPH) : options(_options) {};
+        // Plots keep pointers into their own SVG tree, which a copy of the
+        // tree wouldn't update. Moving keeps every node where it is.
+        PlotBase(const PlotBase&) = delete;
+        PlotBase(PlotBase&&) = default;
+        PlotBase& operator=(const PlotBase&) = delete;
+        PlotBase& operator=(PlotBase&&) = default;
+        virtual ~PlotBase() {};
         void to_svg(const std::string filename);
+        void to_svg(std::ostream& out);
+        void to_svgz(const std::string filename, int level = 6);
+        void to_svgz(std::ostream& out, int level = 6);
+
+        inline void hoist_styles(size_t min_uses = 2) {
+            /** Replace repeated presentation attributes with CSS classes */
+            this->root.hoist_styles(min_uses);
+        }
+
+        SVG::NumberFormat number_format; /*< How coordinates are written out */
+        size_t parallel_threshold = 1 << 20; /*< Estimated output bytes before to_svg() uses threads */
 
     protected:
         SVG::SVG root;
@@ -515,16 +1904,31 @@ namespace Graphs {
      *  which create SVG elements may use the methods x1(), x2(), y1(), and y2()
      *  to get the boundaries of the drawing area.
      *
-     *  T: Should be either CategoricalData or NumericData
+     *  T: Should be CategoricalData, NumericData or one of their views
      */
     template<typename T>
     class Graph : public PlotBase {
     public:
         Graph(GraphOptions _options = DEFAULT_GRAPH);
 
+        /** Draw a layer from data and return it
+         *
+         *  An append() which widens the axes redraws point and line layers
+         *  into new elements. The ones returned here then stay valid until
+         *  the graph is destroyed, but are empty and no longer part of the
+         *  document.
+         */
         SVG::SVG* make_bar(T& data, const std::string color = QUALITATIVE_COLORS[0]);
         SVG::SVG* make_point(T& data, const std::string color = QUALITATIVE_COLORS[0]);
-        SVG::Path make_line(T& data, const std::string color = QUALITATIVE_COLORS[0]);
+        SVG::Element* make_line(T& data, const std::string color = QUALITATIVE_COLORS[0]);
+
+        /** Like make_point() and make_line() for ChunkedData, except the
+         *  marks are only generated when the plot is written out, reading
+         *  the data again a chunk at a time. data must outlive every
+         *  call to to_svg().
+         */
+        SVG::Element* stream_point(T& data, const std::string color = QUALITATIVE_COLORS[0]);
+        SVG::Element* stream_line(T& data, const std::string color = QUALITATIVE_COLORS[0]);
 
         inline void plot(T& data) {
             this->rect = CartesianCoordinates<T>(this->options, data);
@@ -532,6 +1936,10 @@ namespace Graphs {
             this->make_y_axis(data);
         }
 
+        void append(T& data, const std::vector<typename T::value_type>& x,
+            const std::vector<typename T::value_type>& y,
+            const std::vector<typename T::value_type>& z = {});
+
         inline void set_title(const std::string title) {
             this->title->content = title;
         }
@@ -546,12 +1954,58 @@ namespace Graphs {
 
         int bar_spacing = 10;
         int tick_size = 5;
+        PointMode point_mode = PointMode::CIRCLES;
+        Downsampling line_downsampling = Downsampling::NONE;
+        float bin_size = 2;  /*< Cell size in pixels for PointMode::BINNED */
+        int bin_levels = 8;  /*< Number of distinct opacities used by PointMode::BINNED */
+        size_t raster_threshold = 1000000; /*< Datasets larger than this are drawn as a PNG */
+        size_t point_chunk = 1 << 14;      /*< Points per task when generating marks in parallel */
+        float raster_scale = 2;            /*< Raster pixels per SVG pixel */
+        float hysteresis = 0.25f; /*< Headroom added past the data when append() widens an axis */
 
     protected:
+        /** A layer drawn by make_point() or make_line() which append() keeps up to date */
+        struct LiveMark {
+            T* data;
+            SVG::Element* layer;
+            std::string color;
+            bool line;
+            bool incremental; /*< Whether new samples can simply be added to the layer */
+            size_t drawn;     /*< Number of samples in the layer */
+        };
+
+        /** Stand-in dataset reporting the current axis bounds, used to
+         *  relabel axes after append() has widened them
+         */
+        struct AxisBounds : public DatasetBase {
+            size_t n;
+            long double x_lo, x_hi, y_lo, y_hi;
+
+            inline const size_t size() override { return n; }
+            inline long double x_min() override { return x_lo; }
+            inline long double x_max() override { return x_hi; }
+            inline long double y_min() override { return y_lo; }
+            inline long double y_max() override { return y_hi; }
+        };
+
         CartesianCoordinates<T> rect; /*< Used to map stuff onto the drawing area */
+        std::vector<LiveMark> live_marks;
 
         void make_x_axis(DatasetBase &data);
         void make_y_axis(DatasetBase &data);
+        std::vector<SVG::SVG> make_point_layers(const std::vector<T*>& datasets,
+            const std::vector<std::string>& colors);
+        SVG::SVG make_bar_layer(T& data, const std::string& color);
+        SVG::SVG make_bins(T& data, const std::string& color);
+        SVG::Image make_raster(T& data, const std::string& color, bool lines);
+        SVG::Element* draw_line(T& data, const std::string& color);
+
+        template<typename F>
+        static void read_mapped(T& data, const CartesianCoordinates<T>& rect, F func);
+        static void write_raster(SVG::Writer& out, T& data, const CartesianCoordinates<T>& rect,
+            float scale, const std::string& color, bool lines);
+        void redraw(LiveMark& mark);
+        void replace_layer(SVG::Element* old_layer, SVG::Element* new_layer, bool handed_out = false);
 
         SVG::Element* title = nullptr; /*< Pointer set by constructor */
         SVG::Element* xlab = nullptr;
@@ -609,10 +2063,11 @@ namespace Graphs {
             .set_attr("text-anchor", "middle");
 
         // So we can dynamically change text content later
-        this->title = title_wrapper.add_child(title);
-        this->xlab = xlab_wrapper.add_child(xlab);
-        this->ylab = ylab_wrapper.add_child(ylab);
-        this->root.add_child(title_wrapper, xlab_wrapper, ylab_wrapper);
+        this->title = title_wrapper.add_child(std::move(title));
+        this->xlab = xlab_wrapper.add_child(std::move(xlab));
+        this->ylab = ylab_wrapper.add_child(std::move(ylab));
+        this->root.add_child(std::move(title_wrapper),
+            std::move(xlab_wrapper), std::move(ylab_wrapper));
     }
 
     template<class T>
@@ -623,9 +2078,9 @@ namespace Graphs {
         *                    left or center aligned wrt the bars
         */
 
-        this->x_axis_group = (SVG::Group*)this->root.add_child(SVG::Group());
-        this->x_axis = (SVG::Line*)x_axis_group->add_child(
-            SVG::Line(rect.x1, rect.x2, rect.y2, rect.y2));
+        this->x_axis_group = this->root.emplace_child<SVG::Group>();
+        this->x_axis = x_axis_group->emplace_child<SVG::Line>(
+            rect.x1, rect.x2, rect.y2, rect.y2);
         x_axis->set_attr("stroke", "#cccccc").set_attr("stroke-width", 1);
 
         std::vector<std::string> x_labels = data.x_labels();
@@ -648,30 +2103,31 @@ namespace Graphs {
                 break;
 
             coord = x_axis->along(i / n + offset);
-            ticks.add_child(SVG::Line(
+            ticks.emplace_child<SVG::Line>(
                 coord.first, coord.first,
                 coord.second, coord.second + (float)tick_size
-            ));
+            );
 
             // Use translate() to set location rather than x, y
-            // attributes so rotation works properly
+            // attributes so rotation works properly. The string is built
+            // now, so it follows number_format as set when the axis is made.
             SVG::Text label(0, 0, x_labels[i]);
             label.set_attr("transform", "translate(" +
-                std::to_string(coord.first) + "," +
-                std::to_string(rect.y2 + tick_size + 10) // Space label further south from ticks
+                SVG::format_number(coord.first, this->number_format) + "," +
+                SVG::format_number(rect.y2 + tick_size + 10, this->number_format) // Space label further south from ticks
                 + ") rotate(75)");
-            tick_text.add_child(label);
+            tick_text.add_child(std::move(label));
         }
 
-        this->x_axis_group->add_child(ticks, tick_text);
+        this->x_axis_group->add_child(std::move(ticks), std::move(tick_text));
     }
 
     template <class T>
     void Graph<T>::make_y_axis(DatasetBase &data) {
         const size_t num_labels = 10;
-        this->y_axis_group = (SVG::Group*)this->root.add_child(SVG::Group());
-        this->y_axis = (SVG::Line*)y_axis_group->add_child(
-            SVG::Line(rect.x1, rect.x1, rect.y1, rect.y2));
+        this->y_axis_group = this->root.emplace_child<SVG::Group>();
+        this->y_axis = y_axis_group->emplace_child<SVG::Line>(
+            rect.x1, rect.x1, rect.y1, rect.y2);
         y_axis->set_attr("stroke", "#cccccc").set_attr("stroke-width", 1);
 
         std::vector<std::string> y_labels = data.y_labels(10);
@@ -686,17 +2142,16 @@ namespace Graphs {
         // Ticks are represented as tiny lines
         for (size_t i = 0; i < num_labels; i++) {
             coord = y_axis->along((float)(num_labels - i) / num_labels);
-            ticks.add_child(SVG::Line(
-                coord.first - 5, coord.first, coord.second, coord.second));
-tick_text.add_child(SVG::Text(coord.first - 5, coord.second, y_labels[i]));
+            ticks.emplace_child<SVG::Line>(
+                coord.first - 5, coord.first, coord.second, coord.second);
+            tick_text.emplace_child<SVG::Text>(coord.first - 5, coord.second, y_labels[i]);
         }
 
-        this->y_axis_group->add_child(ticks, tick_text);
+        this->y_axis_group->add_child(std::move(ticks), std::move(tick_text));
     }
 
-    template<>
-    inline SVG::SVG* Graph<CategoricalData>::make_bar(
-        CategoricalData& data, const std::string color) {
+    template<class T>
+    inline SVG::SVG Graph<T>::make_bar_layer(T& data, const std::string& color) {
         /** Distribute bars evenly across graph canvas */
         SVG::SVG bars;
         bars.set_attr("fill", color);
@@ -708,48 +2163,553 @@ tick_text.add_child(SVG::Text(coord.first - 5, coord.second, y_labels[i]));
         float bar_height;
 
         // Add a bar for every bin
-        for (auto it = data.y_values.begin(); it != data.y_values.end(); ++it) {
-            bar_height = (*it / (rect.range_max - rect.range_min)) * (rect.y2 - rect.y1);
-            bars.add_child(SVG::Rect(temp_x1, rect.y2 - bar_height,
-                x_tick_space - bar_spacing, bar_height));
+        for (size_t i = 0; i < data.size(); i++) {
+            bar_height = (data.y_values[i] / (rect.range_max - rect.range_min)) * (rect.y2 - rect.y1);
+            bars.emplace_child<SVG::Rect>(temp_x1, rect.y2 - bar_height,
+                x_tick_space - bar_spacing, bar_height);
             temp_x1 += x_tick_space;
         }
 
-        return (SVG::SVG*)this->root.add_child(bars);
+        return bars;
+    }
+
+    template<class T>
+    inline SVG::SVG* Graph<T>::make_bar(T& data, const std::string color) {
+        return this->root.add_child(this->make_bar_layer(data, color));
     }
 
     template<class T>
     inline SVG::SVG* Graph<T>::make_point(T& data, const std::string color) {
-        std::pair<float, float> coord;
-        float dot_radius = 2;
-        SVG::SVG dots;
-        dots.set_attr("fill", color);
+        SVG::SVG* dots = this->root.add_child(
+            std::move(this->make_point_layers({ &data }, { color })[0]));
+
+        this->live_marks.push_back({ &data, dots, color, false,
+            this->point_mode != PointMode::BINNED && data.size() <= this->raster_threshold,
+            data.size() });
+        return dots;
+    }
+
+    template<class T>
+    inline std::vector<SVG::SVG> Graph<T>::make_point_layers(
+        const std::vector<T*>& datasets, const std::vector<std::string>& colors) {
+        /** Build one layer of markers per dataset
+         *
+         *  Vector markers are generated by tasks covering up to point_chunk
+         *  points of one dataset each, so work is spread across datasets
+         *  and across chunks of a single large dataset. Every task builds
+         *  its own fragment, and fragments are stitched together in order,
+         *  so the result is the same as generating the points one by one.
+         */
+        struct Task {
+            size_t layer, begin, end;
+        };
+
+        std::vector<SVG::SVG> layers(datasets.size());
+        std::vector<SVG::CirclePath*> batched(datasets.size(), nullptr);
+        std::vector<Task> tasks;
+        size_t total = 0;
+
+        for (size_t i = 0; i < datasets.size(); i++) {
+            T& data = *datasets[i];
+            if (this->point_mode == PointMode::BINNED) {
+                layers[i] = this->make_bins(data, colors[i]);
+            }
+            else if (data.size() > this->raster_threshold) {
+                layers[i].add_child(this->make_raster(data, colors[i], false));
+            }
+            else {
+                layers[i].set_attr("fill", colors[i]);
+                if (this->point_mode == PointMode::PATH) {
+                    batched[i] = layers[i].emplace_child<SVG::CirclePath>();
+                    batched[i]->reserve(data.size());
+                }
+
+                for (size_t begin = 0; begin < data.size(); begin += point_chunk)
+                    tasks.push_back({ i, begin, std::min(begin + point_chunk, data.size()) });
+                total += data.size();
+            }
+        }
+
+        std::vector<SVG::Element> fragments(tasks.size());
+        parallel_tasks(tasks.size(), parallel_chunks(total, point_chunk), [&](size_t t) {
+            T& data = *datasets[tasks[t].layer];
+            SVG::Element& fragment = fragments[t];
+            float dot_radius = 2;
+
+            SVG::CirclePath* markers = nullptr;
+            if (this->point_mode == PointMode::PATH) {
+                markers = fragment.emplace_child<SVG::CirclePath>();
+                markers->reserve(tasks[t].end - tasks[t].begin);
+            }
+
+            const size_t begin = tasks[t].begin, n = tasks[t].end - begin;
+            std::vector<float> xs(n), ys(n);
+            rect.map_range(data.x_values.data() + begin, data.y_values.data() + begin,
+                n, xs.data(), ys.data());
+
+            for (size_t i = 0; i < n; i++) {
+                if (!data.z_values.empty())
+                    dot_radius = (float)data.z_values[begin + i];
+
+                if (markers)
+                    markers->add(xs[i], ys[i], dot_radius);
+                else
+                    fragment.emplace_child<SVG::Circle>(xs[i], ys[i], dot_radius);
+            }
+        });
+
+        // Stitch fragments into their layers in order
+        for (size_t t = 0; t < tasks.size(); t++) {
+            if (batched[tasks[t].layer])
+                batched[tasks[t].layer]->append(*(SVG::CirclePath*)fragments[t].children[0]);
+            else
+                layers[tasks[t].layer].append_children(std::move(fragments[t]));
+        }
+
+        return layers;
+    }
 
-        // Add each dot
-        for (size_t i = 0, ilen = data.size(); i < ilen; i++) {
-            if (!data.z_values.empty())
-                dot_radius = data.z_values[i];
+    template<class T>
+    inline SVG::SVG Graph<T>::make_bins(T& data, const std::string& color) {
+        /** Count points per bin_size x bin_size cell of the drawing area and
+         *  draw one square per occupied cell, so output size is bounded by
+         *  the canvas rather than the number of points. Each chunk of points
+         *  is counted into its own grid on a separate thread and the grids
+         *  are summed afterwards.
+         */
+        const size_t cols = (size_t)ceil((rect.x2 - rect.x1) / bin_size) + 1,
+            rows = (size_t)ceil((rect.y2 - rect.y1) / bin_size) + 1,
+            chunks = parallel_chunks(data.size(), 1 << 16);
+        std::vector<std::vector<size_t>> grids(chunks);
+
+        parallel_for(data.size(), chunks, [&](size_t begin, size_t end, size_t chunk) {
+            std::vector<size_t>& counts = grids[chunk];
+            counts.resize(cols * rows);
+
+            // Map a block at a time to keep the scratch buffers small
+            const size_t block = 4096;
+            std::vector<float> xs(block), ys(block);
+
+            for (size_t start = begin; start < end; start += block) {
+                size_t n = std::min(block, end - start);
+                rect.map_range(data.x_values.data() + start, data.y_values.data() + start,
+                    n, xs.data(), ys.data());
+
+                for (size_t i = 0; i < n; i++) {
+                    float col = floor((xs[i] - rect.x1) / bin_size),
+                        row = floor((ys[i] - rect.y1) / bin_size);
+
+                    // Also rejects NaN
+                    if (col >= 0 && col < cols && row >= 0 && row < rows)
+                        counts[(size_t)row * cols + (size_t)col]++;
+                }
+            }
+        });
+
+        std::vector<size_t>& counts = grids[0];
+        counts.resize(cols * rows);
+        for (size_t i = 1; i < chunks; i++)
+            for (size_t cell = 0; cell < counts.size(); cell++)
+                counts[cell] += grids[i][cell];
+
+        // Opacity grows with the log of the count, quantized to bin_levels steps
+        size_t max_count = *std::max_element(counts.begin(), counts.end());
+        const float levels = (float)std::max(bin_levels, 1),
+            scale = max_count > 1 ? (float)log((double)max_count) : 1;
+
+        SVG::SVG bins;
+        bins.set_attr("fill", color);
+
+        for (size_t row = 0; row < rows; row++) {
+            for (size_t col = 0; col < cols; col++) {
+                size_t count = counts[row * cols + col];
+                if (!count) continue;
+
+                float level = ceil(((float)log((double)count) / scale) * (levels - 1)) + 1;
+                bins.emplace_child<SVG::Rect>(
+                    rect.x1 + col * bin_size, rect.y1 + row * bin_size, bin_size, bin_size
+                )->set_attr(SVG::Attr::FILL_OPACITY, std::min(level, levels) / levels);
+            }
+        }
+
+        return bins;
+    }
+
+    template<class T>
+    inline SVG::Image Graph<T>::make_raster(T& data, const std::string& color, bool lines) {
+        /** Draw points or a line into a bitmap covering the drawing area
+         *  and embed it as a PNG, so the layer's size no longer depends on
+         *  the number of data points
+         */
+        const float scale = std::max(raster_scale, 1.0f),
+            width = rect.x2 - rect.x1, height = rect.y2 - rect.y1;
+        SVG::Raster canvas((size_t)ceil(width * scale), (size_t)ceil(height * scale));
+        SVG::Raster::Color fill = SVG::Raster::parse_color(color);
+
+        // Map to SVG coordinates, then to raster pixels
+        std::vector<float> xs(data.size()), ys(data.size());
+        rect.map(data.x_values.data(), data.y_values.data(), data.size(), xs.data(), ys.data());
+        for (size_t i = 0; i < xs.size(); i++) {
+            xs[i] = (xs[i] - rect.x1) * scale;
+            ys[i] = (ys[i] - rect.y1) * scale;
+        }
+
+        if (lines) {
+            for (size_t i = 1; i < xs.size(); i++)
+                canvas.draw_line(xs[i - 1], ys[i - 1], xs[i], ys[i], scale, fill);
+        }
+        else {
+            float dot_radius = 2;
+            for (size_t i = 0; i < xs.size(); i++) {
+                if (!data.z_values.empty())
+                    dot_radius = (float)data.z_values[i];
 
-            coord = rect.map(data.x_values[i], data.y_values[i]);
-            dots.add_child(SVG::Circle(coord.first, coord.second, (float)dot_radius));
+                canvas.fill_circle(xs[i], ys[i], dot_radius * scale, fill);
+            }
         }
 
-        return (SVG::SVG*)this->root.add_child(dots);
+        return SVG::Image(rect.x1, rect.y1, width, height, canvas.to_data_uri());
+    }
+
+    template<class T>
+    inline SVG::Element* Graph<T>::make_line(T& data, const std::string color) {
+        SVG::Element* line = this->draw_line(data, color);
+        this->live_marks.push_back({ &data, line, color, true,
+            this->line_downsampling == Downsampling::NONE && data.size() <= this->raster_threshold,
+            data.size() });
+        return line;
     }
 
     template<class T>
-    inline SVG::Path Graph<T>::make_line(T& data, const std::string color) {
+    inline SVG::Element* Graph<T>::draw_line(T& data, const std::string& color) {
+        if (data.size() > this->raster_threshold)
+            return this->root.add_child(this->make_raster(data, color, true));
+
         SVG::Path line;
-        std::pair<float, float> coord;
+        std::vector<float> xs(data.size()), ys(data.size());
+        rect.map(data.x_values.data(), data.y_values.data(), data.size(), xs.data(), ys.data());
+
+        if (this->line_downsampling == Downsampling::NONE) {
+            line.reserve(data.size());
+            for (size_t i = 0; i < xs.size(); i++)
+                line.line_to(xs[i], ys[i]);
+
+            return this->root.add_child(std::move(line));
+        }
 
-        for (size_t i = 0, ilen = data.size(); i < ilen; i++) {
-            coord = rect.map(data.x_values[i], data.y_values[i]);
+        /** Reduce the mapped vertices to a number proportional to the
+         *  width of the drawing area before they reach the path
+         */
+        Polyline coords;
+        coords.reserve(data.size());
+        for (size_t i = 0; i < xs.size(); i++)
+            coords.push_back(std::make_pair(xs[i], ys[i]));
+
+        if (this->line_downsampling == Downsampling::M4)
+            coords = downsample_m4(coords);
+        else
+            coords = downsample_lttb(coords, 2 * (size_t)ceil(rect.x2 - rect.x1));
+
+        line.reserve(coords.size());
+        for (auto& coord : coords)
             line.line_to(coord);
+
+        return this->root.add_child(std::move(line));
+    }
+
+    template<class T>
+    inline SVG::Element* Graph<T>::stream_point(T& data, const std::string color) {
+        /** Produces the same markup as make_point(), except that
+         *  PointMode::PATH and PointMode::BINNED draw one path per chunk
+         */
+        const CartesianCoordinates<T> rect = this->rect;
+        SVG::Element& root = this->root;
+        SVG::Element* layer;
+
+        if (data.size() > this->raster_threshold) {
+            const float scale = std::max(this->raster_scale, 1.0f);
+            layer = root.emplace_child<SVG::Stream>("svg", [&data, rect, scale, color](SVG::Writer& out) {
+                out << '\t';
+                Graph<T>::write_raster(out, data, rect, scale, color, false);
+                out << '\n';
+            });
+        }
+        else {
+            const bool path = this->point_mode != PointMode::CIRCLES;
+            layer = root.emplace_child<SVG::Stream>("svg", [&data, rect, path](SVG::Writer& out) {
+                Graph<T>::read_mapped(data, rect, [&](auto& chunk,
+                    const std::vector<float>& xs, const std::vector<float>& ys) {
+                    float dot_radius = 2;
+                    SVG::CirclePath markers;
+                    if (path) markers.reserve(xs.size());
+
+                    for (size_t i = 0; i < xs.size(); i++) {
+                        if (!chunk.z_values.empty())
+                            dot_radius = (float)chunk.z_values[i];
+
+                        if (path) {
+                            markers.add(xs[i], ys[i], dot_radius);
+                        }
+                        else {
+                            out << '\t';
+                            SVG::Circle(xs[i], ys[i], dot_radius).write(out);
+                            out << '\n';
+                        }
+                    }
+
+                    if (path) {
+                        out << '\t';
+                        markers.write(out);
+                        out << '\n';
+                    }
+                });
+            });
+
+            layer->set_attr(SVG::Attr::XMLNS, "http://www.w3.org/2000/svg");
+            layer->set_attr("fill", color);
+            return layer;
         }
 
-        // Temporary
-        this->root.add_child(line);
-        return line;
+        layer->set_attr(SVG::Attr::XMLNS, "http://www.w3.org/2000/svg");
+        return layer;
+    }
+
+    template<class T>
+    inline SVG::Element* Graph<T>::stream_line(T& data, const std::string color) {
+        /** Produces the same markup as make_line(). Downsampling is done
+         *  with M4 on each chunk separately, which still keeps every pixel
+         *  column's extremes.
+         */
+        const CartesianCoordinates<T> rect = this->rect;
+        SVG::Element& root = this->root;
+
+        if (data.size() > this->raster_threshold) {
+            const float scale = std::max(this->raster_scale, 1.0f);
+            return root.emplace_child<SVG::Stream>("", [&data, rect, scale, color](SVG::Writer& out) {
+                Graph<T>::write_raster(out, data, rect, scale, color, true);
+            });
+        }
+
+        const bool downsample = this->line_downsampling != Downsampling::NONE;
+        return root.emplace_child<SVG::Stream>("", [&data, rect, downsample](SVG::Writer& out) {
+            bool started = false;
+            Graph<T>::read_mapped(data, rect, [&](auto&,
+                const std::vector<float>& xs, const std::vector<float>& ys) {
+                Polyline coords;
+                coords.reserve(xs.size());
+                for (size_t i = 0; i < xs.size(); i++)
+                    coords.push_back(std::make_pair(xs[i], ys[i]));
+                if (downsample)
+                    coords = downsample_m4(coords);
+
+                for (auto& coord : coords) {
+                    out << (started ? " L " : "<path d=\"M ") << coord.first << ' ' << coord.second;
+                    started = true;
+                }
+            });
+
+            out << (started ? "\" />" : "<path />");
+        });
+    }
+
+    template<class T>
+    template<typename F>
+    inline void Graph<T>::read_mapped(T& data, const CartesianCoordinates<T>& rect, F func) {
+        /** Read data a chunk at a time, calling func(chunk, xs, ys) with
+         *  each chunk's points mapped onto the drawing area
+         */
+        std::vector<float> xs, ys;
+        data.read([&](auto& chunk) {
+            xs.resize(chunk.size());
+            ys.resize(chunk.size());
+            rect.map(chunk.x_values.data(), chunk.y_values.data(), chunk.size(), xs.data(), ys.data());
+            func(chunk, xs, ys);
+        });
+    }
+
+    template<class T>
+    inline void Graph<T>::write_raster(SVG::Writer& out, T& data,
+        const CartesianCoordinates<T>& rect, float scale, const std::string& color, bool lines) {
+        /** Draw every chunk into one bitmap and write it as an image, like make_raster() */
+        const float width = rect.x2 - rect.x1, height = rect.y2 - rect.y1;
+        SVG::Raster canvas((size_t)ceil(width * scale), (size_t)ceil(height * scale));
+        SVG::Raster::Color fill = SVG::Raster::parse_color(color);
+        bool started = false;
+        float last_x = 0, last_y = 0;
+
+        Graph<T>::read_mapped(data, rect, [&](auto& chunk,
+            const std::vector<float>& xs, const std::vector<float>& ys) {
+            float dot_radius = 2;
+            for (size_t i = 0; i < xs.size(); i++) {
+                float x = (xs[i] - rect.x1) * scale, y = (ys[i] - rect.y1) * scale;
+                if (lines) {
+                    if (started)
+                        canvas.draw_line(last_x, last_y, x, y, scale, fill);
+                    last_x = x;
+                    last_y = y;
+                    started = true;
+                }
+                else {
+                    if (!chunk.z_values.empty())
+                        dot_radius = (float)chunk.z_values[i];
+                    canvas.fill_circle(x, y, dot_radius * scale, fill);
+                }
+            }
+        });
+
+        SVG::Image(rect.x1, rect.y1, width, height, canvas.to_data_uri()).write(out);
+    }
+
+    template<class T>
+    inline void Graph<T>::append(T& data, const std::vector<typename T::value_type>& x,
+        const std::vector<typename T::value_type>& y,
+        const std::vector<typename T::value_type>& z) {
+        /** Add samples to a dataset that has already been plotted, and
+         *  extend the layers drawn from it in place
+         *
+         *  While the new samples stay inside the current axes, only they
+         *  are mapped and drawn. Otherwise the axes are widened past the
+         *  data by a margin of hysteresis times the data's span, so the
+         *  next few appends fit again, and every layer is redrawn into a
+         *  new element, detaching the one make_point() or make_line()
+         *  returned.
+         */
+        if (x.size() != y.size() || (!data.z_values.empty() && z.size() != y.size()))
+            throw std::runtime_error("Appended x, y and z values have different lengths.");
+        if (data.z_values.empty() && !z.empty() && !data.x_values.empty())
+            throw std::runtime_error("Can't append z values to a dataset without them.");
+        if (!this->x_axis_group)
+            throw std::runtime_error("plot() must be called before append().");
+        if (x.empty())
+            return;
+
+        data.x_values.insert(data.x_values.end(), x.begin(), x.end());
+        data.y_values.insert(data.y_values.end(), y.begin(), y.end());
+        if (!data.z_values.empty())
+            data.z_values.insert(data.z_values.end(), z.begin(), z.end());
+
+        // Only the new samples need to be scanned
+        auto x_range = std::minmax_element(x.begin(), x.end());
+        auto y_range = std::minmax_element(y.begin(), y.end());
+        AxisBounds bounds;
+        bounds.n = data.size();
+        bounds.x_lo = std::min(rect.domain_min, (long double)*x_range.first);
+        bounds.x_hi = std::max(rect.domain_max, (long double)*x_range.second);
+        bounds.y_lo = std::min(rect.range_min, (long double)*y_range.first);
+        bounds.y_hi = std::max(rect.range_max, (long double)*y_range.second);
+
+        const bool rescale = bounds.x_lo < rect.domain_min || bounds.x_hi > rect.domain_max
+            || bounds.y_lo < rect.range_min || bounds.y_hi > rect.range_max;
+
+        if (!rescale) {
+            for (auto& mark : this->live_marks) {
+                if (mark.data != &data)
+                    continue;
+
+                if (!mark.incremental || data.size() > this->raster_threshold) {
+                    this->redraw(mark);
+                    continue;
+                }
+
+                const size_t begin = mark.drawn, n = data.size() - begin;
+                std::vector<float> xs(n), ys(n);
+                rect.map_range(data.x_values.data() + begin, data.y_values.data() + begin,
+                    n, xs.data(), ys.data());
+
+                if (mark.line) {
+                    SVG::Path* line = (SVG::Path*)mark.layer;
+                    for (size_t i = 0; i < n; i++)
+                        line->line_to(xs[i], ys[i]);
+                }
+                else {
+                    float dot_radius = 2;
+                    SVG::Element* dots = mark.layer;
+                    SVG::CirclePath* markers = dots->children.empty() ? nullptr :
+                        dynamic_cast<SVG::CirclePath*>(dots->children[0]);
+
+                    for (size_t i = 0; i < n; i++) {
+                        if (!data.z_values.empty())
+                            dot_radius = (float)data.z_values[begin + i];
+
+                        if (markers)
+                            markers->add(xs[i], ys[i], dot_radius);
+                        else
+                            dots->emplace_child<SVG::Circle>(xs[i], ys[i], dot_radius);
+                    }
+                }
+
+                mark.drawn = data.size();
+            }
+
+            return;
+        }
+
+        // Widen only the sides the data has grown past
+        const long double x_pad = this->hysteresis * (bounds.x_hi - bounds.x_lo),
+            y_pad = this->hysteresis * (bounds.y_hi - bounds.y_lo);
+        if (bounds.x_lo < rect.domain_min) bounds.x_lo -= x_pad;
+        if (bounds.x_hi > rect.domain_max) bounds.x_hi += x_pad;
+        if (bounds.y_lo < rect.range_min) bounds.y_lo -= y_pad;
+        if (bounds.y_hi > rect.range_max) bounds.y_hi += y_pad;
+
+        rect.domain_min = bounds.x_lo;
+        rect.domain_max = bounds.x_hi;
+        rect.range_min = bounds.y_lo;
+        rect.range_max = bounds.y_hi;
+
+        SVG::Element* old_axis = this->x_axis_group;
+        this->make_x_axis(bounds);
+        this->replace_layer(old_axis, this->x_axis_group);
+
+        old_axis = this->y_axis_group;
+        this->make_y_axis(bounds);
+        this->replace_layer(old_axis, this->y_axis_group);
+
+        for (auto& mark : this->live_marks)
+            this->redraw(mark);
+    }
+
+    template<class T>
+    inline void Graph<T>::redraw(LiveMark& mark) {
+        /** Replace a layer with one drawn from scratch */
+        SVG::Element* layer;
+        if (mark.line) {
+            layer = this->draw_line(*mark.data, mark.color);
+            mark.incremental = this->line_downsampling == Downsampling::NONE;
+        }
+        else {
+            layer = this->root.add_child(std::move(
+                this->make_point_layers({ mark.data }, { mark.color })[0]));
+            mark.incremental = this->point_mode != PointMode::BINNED;
+        }
+
+        mark.incremental = mark.incremental && mark.data->size() <= this->raster_threshold;
+        this->replace_layer(mark.layer, layer, true);
+        mark.layer = layer;
+        mark.drawn = mark.data->size();
+    }
+
+    template<class T>
+    inline void Graph<T>::replace_layer(SVG::Element* old_layer, SVG::Element* new_layer, bool handed_out) {
+        /** Move new_layer (the last child of root) into old_layer's place
+         *  The old layer is destroyed and its memory reused by later layers.
+         *  If it was handed out to the caller, only its children are.
+         */
+        auto& children = this->root.children;
+        auto it = std::find(children.begin(), children.end(), old_layer);
+        if (it != children.end()) {
+            *it = new_layer;
+            children.pop_back();
+
+            if (handed_out) {
+                for (auto child : old_layer->children)
+                    this->root.discard(child);
+                old_layer->children.clear();
+            }
+            else {
+                this->root.discard(old_layer);
+            }
+        }
     }
 
     template<class T>
@@ -775,28 +2735,37 @@ tick_text.add_child(SVG::Text(coord.first - 5, coord.second, y_labels[i]));
         std::vector<SVG::SVG*> data_groups;
     };
 
-    template<>
-    inline void MultiGraph<CategoricalData>::make_bar(
-        DatasetCollection<CategoricalData>& data,
+    template<class T>
+    inline void MultiGraph<T>::make_bar(
+        DatasetCollection<T>& data,
         const std::string color
     ) {
         SVG::SVG* bar_container;
         std::vector<std::string> fill_colors = data.get_fill();
         float bar_size = 0, bar_x = 0;
 
+        // Build each dataset's bars on its own task
+        std::vector<SVG::SVG> layers(data.datasets.size());
+        size_t total = 0;
+        for (auto& dataset : data.datasets)
+            total += dataset->size();
+
+        parallel_tasks(layers.size(), parallel_chunks(total, this->point_chunk), [&](size_t i) {
+            layers[i] = this->make_bar_layer(*data.datasets[i], fill_colors[i]);
+        });
+
         for (size_t i = 0; i < data.datasets.size(); i++) {
-            bar_container = Graph<CategoricalData>::make_bar(
-                data.datasets[i], fill_colors[i]);
+            bar_container = this->root.add_child(std::move(layers[i]));
             this->data_groups.push_back(bar_container);
             for (auto it = bar_container->children.begin();
                 it != bar_container->children.end(); ++it) {
                 if (bar_size == 0)
-                    bar_size = std::stof(it->get()->attr["width"]);
+                    bar_size = (*it)->attr.get_float(SVG::Attr::WIDTH);
 
                 // Resize and replace bars in place
-                bar_x = std::stof(it->get()->attr["x"]);
-                it->get()->set_attr("width", bar_size/data.datasets.size());
-                it->get()->set_attr("x", bar_x + ((float)i * bar_size / data.datasets.size()));
+                bar_x = (*it)->attr.get_float(SVG::Attr::X);
+                (*it)->set_attr("width", bar_size/data.datasets.size());
+                (*it)->set_attr("x", bar_x + ((float)i * bar_size / data.datasets.size()));
             }
         }
     }
@@ -806,11 +2775,13 @@ tick_text.add_child(SVG::Text(coord.first - 5, coord.second, y_labels[i]));
         DatasetCollection<T>& data,
         const std::string color
     ) {
-        std::vector<std::string> fill_colors = data.get_fill();
-        for (size_t i = 0; i < data.datasets.size(); i++) {
-            this->data_groups.push_back(Graph<T>::make_point(
-                data.datasets[i], fill_colors[i]));
-        }
+        std::vector<T*> datasets;
+        for (auto& dataset : data.datasets)
+            datasets.push_back(dataset.get());
+
+        auto layers = this->make_point_layers(datasets, data.get_fill());
+        for (auto& layer : layers)
+            this->data_groups.push_back(this->root.add_child(std::move(layer)));
     }
 
     template<class T>
@@ -827,10 +2798,10 @@ tick_text.add_child(SVG::Text(coord.first - 5, coord.second, y_labels[i]));
 
         size_t i = 1; // Temporary, I hope
         for (auto it = data.datasets.begin(); it != data.datasets.end(); ++it) {
-            if (it->name.empty())
+            if ((*it)->name.empty())
                 labels.push_back("Group " + std::to_string(i));
             else
-                labels.push_back(it->name);
+                labels.push_back((*it)->name);
             i++;
         }
 
@@ -840,7 +2811,7 @@ tick_text.add_child(SVG::Text(coord.first - 5, coord.second, y_labels[i]));
 
         legend.root.set_attr("x", rect.x2 + 10);
         legend.root.set_attr("y", (rect.y2 - legend.get_height()) / 2);
-        this->root.add_child(legend.root);
+        this->root.add_child(std::move(legend.root));
     }
 
     class RadarChart : public MultiGraph<CategoricalData> {
@@ -850,6 +2821,11 @@ tick_text.add_child(SVG::Text(coord.first - 5, coord.second, y_labels[i]));
             void set_scale(float min, float max);
             std::pair<float, float> map(float data);
 
+        protected:
+            inline SVG::Element* clone(SVG::NodePool& nodes) const override {
+                return nodes.make<Axis>(*this);
+            }
+
         private:
             float min = 0;
             float max = 1;
@@ -858,7 +2834,7 @@ tick_text.add_child(SVG::Text(coord.first - 5, coord.second, y_labels[i]));
     public:
         RadarChart();
         std::vector<Axis*> axes;
-        void plot(DatasetCollection<CategoricalData> data);
+        void plot(DatasetCollection<CategoricalData>& data);
 
         size_t grid_lines = 10;
 
@@ -888,11 +2864,359 @@ tick_text.add_child(SVG::Text(coord.first - 5, coord.second, y_labels[i]));
     };
     */
 
+    /** Renders many independent plots concurrently
+     *
+     *  Each job builds a plot and writes it with PlotBase::to_svg() on one
+     *  of a fixed number of worker threads. submit() blocks while
+     *  max_pending jobs are already waiting, so producers can't run
+     *  arbitrarily far ahead of the workers.
+     *
+     *  Thread safety: distinct plot objects may be built and written on
+     *  different threads at the same time. The shared defaults
+     *  (QUALITATIVE_COLORS, DEFAULT_GRAPH, DEFAULT_GRAPH_LEGEND) are
+     *  constants, and the attribute name registry is internally locked.
+     *  A single plot object must not be used from two threads at once.
+     *  Large plots still parallelize internally via parallel_for(). Lower
+     *  max_threads to avoid oversubscription when every job is large.
+     */
+    class BatchRenderer {
+    public:
+        struct Stats {
+            size_t jobs = 0;
+            size_t failed = 0;
+            std::vector<double> latency; /*< Seconds per job in submission order, NAN if it failed */
+            double elapsed = 0;          /*< Seconds from construction to finish() */
+
+            inline double throughput() const {
+                /** Jobs completed per second */
+                return elapsed > 0 ? (jobs - failed) / elapsed : 0;
+            }
+        };
+
+        BatchRenderer(size_t threads = 0, size_t max_pending = 0);
+        BatchRenderer(const BatchRenderer&) = delete;
+        BatchRenderer& operator=(const BatchRenderer&) = delete;
+        ~BatchRenderer();
+
+        template<typename F>
+        inline void submit(const std::string& filename, F build) {
+            /** Queue a job which calls build() to make a plot and writes it
+             *  to filename. build() may return the plot by value, as a
+             *  unique_ptr or shared_ptr, or as a raw pointer, which isn't
+             *  deleted afterwards. Throws if finish() has been called.
+             */
+            this->enqueue([filename, build]() {
+                auto plot = build();
+                BatchRenderer::render(plot, filename);
+            });
+        }
+
+        Stats finish();
+
+    private:
+        template<typename P>
+        static inline void render(P& plot, const std::string& filename) {
+            plot.to_svg(filename);
+        }
+
+        template<typename P>
+        static inline void render(std::unique_ptr<P>& plot, const std::string& filename) {
+            plot->to_svg(filename);
+        }
+
+        template<typename P>
+        static inline void render(std::shared_ptr<P>& plot, const std::string& filename) {
+            plot->to_svg(filename);
+        }
+
+        template<typename P>
+        static inline void render(P*& plot, const std::string& filename) {
+            plot->to_svg(filename);
+        }
+
+        void enqueue(std::function<void()> job);
+        void work();
+
+        std::mutex lock;
+        std::condition_variable has_job;
+        std::condition_variable has_room;
+        std::deque<std::pair<size_t, std::function<void()>>> pending;
+        std::vector<std::thread> workers;
+        size_t max_pending;
+        bool stopping = false;
+
+        Stats stats;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    };
+
     class ColumnNotFoundError : public std::runtime_error {
     public:
         ColumnNotFoundError(const std::string& col_name) : std::runtime_error(
             "Couldn't find a column named " + col_name) {};
     };
 
-    std::string to_string(float number, size_t n = 1);
+    /** A read-only memory mapping of an entire file */
+    class MappedFile {
+    public:
+        MappedFile(const std::string& filename);
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile();
+
+        inline const char* data() const { return ptr; }
+        inline size_t size() const { return length; }
+
+    private:
+        const char* ptr = nullptr;
+        size_t length = 0;
+#ifdef _WIN32
+        void* file = nullptr;    /*< Windows HANDLEs */
+        void* mapping = nullptr;
+#endif
+    };
+
+    struct CSVFormat {
+        char delimiter = ',';
+        char quote = '"';
+        size_t chunk_size = 1 << 22; /*< Minimum bytes handed to each thread */
+    };
+
+    /** Loads columns from a CSV file with a header row
+     *
+     *  The file is memory-mapped and split into chunks which are scanned
+     *  in parallel. A chunk's first row is found by tracking which
+     *  newlines end a row for every quoting state the chunk could start
+     *  in, then resolving the actual states in order. Chunks are then
+     *  parsed in parallel straight into the output columns.
+     *
+     *  A quote only starts a quoted field at the beginning of a field.
+     *  Elsewhere it is kept as part of the text. Numeric fields which are
+     *  empty or can't be parsed become NAN. Blank lines are not skipped:
+     *  each one is read as a row with an empty first field.
+     */
+    class CSVReader {
+    public:
+        CSVReader(const std::string& filename, CSVFormat format = CSVFormat());
+
+        inline const std::vector<std::string>& col_names() const { return this->names; }
+        inline size_t size() const { return this->rows; } /*< Number of rows, excluding the header */
+        size_t index_of(const std::string& name) const;
+
+        template<typename V = double>
+        std::vector<std::vector<V>> numeric_columns(const std::vector<std::string>& names);
+        std::vector<std::string> text_column(const std::string& name);
+
+        template<typename V = double>
+        inline BasicNumericData<V> numeric_data(const std::string& x, const std::string& y,
+            const std::string& z = "") {
+            /** Read columns into a dataset, named after the y column */
+            std::vector<std::string> selected = { x, y };
+            if (!z.empty()) selected.push_back(z);
+            auto columns = this->numeric_columns<V>(selected);
+
+            BasicNumericData<V> ret;
+            ret.name = y;
+            ret.x_values = std::move(columns[0]);
+            ret.y_values = std::move(columns[1]);
+            if (!z.empty()) ret.z_values = std::move(columns[2]);
+            return ret;
+        }
+
+        template<typename V = double>
+        inline BasicCategoricalData<V> categorical_data(const std::string& labels,
+            const std::string& values) {
+            BasicCategoricalData<V> ret;
+            ret.name = values;
+            ret.x_values = this->text_column(labels);
+            ret.y_values = std::move(this->numeric_columns<V>({ values })[0]);
+            return ret;
+        }
+
+    private:
+        /** A run of whole rows, parsed by one thread */
+        struct Segment {
+            const char* begin;
+            const char* end;
+            size_t first_row;
+        };
+
+        template<typename F>
+        void parse(const std::vector<size_t>& columns, F store);
+
+        MappedFile file;
+        CSVFormat format;
+        std::vector<std::string> names;
+        std::vector<Segment> segments;
+        size_t rows = 0;
+    };
+
+    /** Reads Arrow IPC files (Feather version 2) with no external dependency
+     *
+     *  The file is memory-mapped and its metadata parsed up front. Columns
+     *  can then be viewed in place with column() and numeric_view(), which
+     *  copy nothing, or converted with the *_column() and *_data() methods.
+     *  Compressed files and union and view types are rejected.
+     */
+    class ArrowReader {
+    public:
+        enum class Type { INT, FLOAT, UTF8, LARGE_UTF8, OTHER };
+
+        /** Where one column's buffers are in one record batch */
+        struct Chunk {
+            const uint8_t* validity = nullptr; /*< Null bitmap, nullptr if there are no nulls */
+            const uint8_t* offsets = nullptr;  /*< Start of each string */
+            const uint8_t* values = nullptr;   /*< Numbers, string bytes or dictionary indices */
+            size_t length = 0;
+            size_t null_count = 0;
+
+            inline bool is_null(size_t i) const {
+                return validity && !((validity[i >> 3] >> (i & 7)) & 1);
+            }
+        };
+
+        struct Field {
+            std::string name;
+            Type type = Type::OTHER; /*< For dictionary columns, the type of the dictionary */
+            int bit_width = 0;       /*< Of integers, floats and dictionary indices */
+            bool is_signed = true;
+            bool dictionary = false; /*< Whether values are indices into a dictionary */
+            int64_t dictionary_id = 0;
+            std::vector<Chunk> chunks; /*< One per record batch */
+        };
+
+        ArrowReader(const std::string& filename);
+
+        inline const std::vector<std::string>& col_names() const { return this->names; }
+        inline size_t size() const { return this->rows; }
+        inline size_t batches() const { return this->batch_rows.size(); }
+        const Field& field(const std::string& name) const;
+
+        template<typename V>
+        inline Column<V> column(const std::string& name, size_t batch = 0) const {
+            /** View a column in one record batch without copying it
+             *
+             *  V must be the column's storage type, e.g. double for float64
+             *  or int64_t for int64, and the column must not have nulls.
+             */
+            const Field& info = this->field(name);
+            if (!stored_as<V>(info))
+                throw std::runtime_error("Column " + name + " isn't stored with the requested type");
+
+            const Chunk& chunk = info.chunks.at(batch);
+            if (chunk.null_count)
+                throw std::runtime_error("Column " + name + " has nulls and can't be viewed in place");
+            if ((uintptr_t)chunk.values % alignof(V))
+                throw std::runtime_error("Column " + name + " isn't aligned");
+            return Column<V>((const V*)chunk.values, chunk.length);
+        }
+
+        template<typename V = double, typename X = V>
+        inline NumericView<V, X> numeric_view(const std::string& x, const std::string& y,
+            const std::string& z = "", size_t batch = 0) const {
+            /** View columns in one record batch without copying them, e.g.
+             *  numeric_view<double, int64_t>() for an int64 x column
+             */
+            NumericView<V, X> ret = z.empty() ?
+                NumericView<V, X>(this->column<X>(x, batch), this->column<V>(y, batch)) :
+                NumericView<V, X>(this->column<X>(x, batch), this->column<V>(y, batch),
+                    this->column<V>(z, batch));
+            ret.name = y;
+            return ret;
+        }
+
+        template<typename V = double, typename X = V>
+        inline ChunkedData<V, X> chunks(const std::string& x, const std::string& y,
+            const std::string& z = "") const {
+            /** Read the columns one record batch at a time, viewing them in
+             *  place where column() allows it. Floating point columns are
+             *  copied and converted otherwise, with nulls as NAN. Integer
+             *  columns must be viewable in place. This reader must outlive
+             *  the returned dataset.
+             */
+            for (auto& name : { x, y, z })
+                if (!name.empty()) this->field(name);
+
+            ChunkedData<V, X> ret([this, x, y, z](const typename ChunkedData<V, X>::Visitor& visit) {
+                std::vector<X> x_copy;
+                std::vector<V> y_copy, z_copy;
+
+                for (size_t batch = 0; batch < this->batches(); batch++) {
+                    NumericView<V, X> view = z.empty() ?
+                        NumericView<V, X>(this->batch_column(x, batch, x_copy),
+                            this->batch_column(y, batch, y_copy)) :
+                        NumericView<V, X>(this->batch_column(x, batch, x_copy),
+                            this->batch_column(y, batch, y_copy), this->batch_column(z, batch, z_copy));
+                    visit(view);
+                }
+            });
+
+            ret.name = y;
+            return ret;
+        }
+
+        template<typename V = double>
+        std::vector<V> numeric_column(const std::string& name) const;
+        template<typename V = double>
+        std::vector<V> numeric_column(const std::string& name, size_t batch) const;
+        std::vector<std::string> text_column(const std::string& name) const;
+
+        template<typename V = double>
+        inline BasicNumericData<V> numeric_data(const std::string& x, const std::string& y,
+            const std::string& z = "") const {
+            /** Copy columns from every record batch into a dataset, with nulls as NAN */
+            BasicNumericData<V> ret;
+            ret.name = y;
+            ret.x_values = this->numeric_column<V>(x);
+            ret.y_values = this->numeric_column<V>(y);
+            if (!z.empty()) ret.z_values = this->numeric_column<V>(z);
+            return ret;
+        }
+
+        template<typename V = double>
+        inline BasicCategoricalData<V> categorical_data(const std::string& labels,
+            const std::string& values) const {
+            BasicCategoricalData<V> ret;
+            ret.name = values;
+            ret.x_values = this->text_column(labels);
+            ret.y_values = this->numeric_column<V>(values);
+            return ret;
+        }
+
+    private:
+        template<typename V>
+        static inline bool stored_as(const Field& info) {
+            /** Whether a column's values can be read as V in place */
+            return !info.dictionary && info.bit_width == 8 * sizeof(V) && (
+                std::is_floating_point<V>::value ? info.type == Type::FLOAT :
+                info.type == Type::INT && info.is_signed == std::is_signed<V>::value);
+        }
+
+        template<typename V>
+        static void convert(const Field& info, const Chunk& chunk, V* out);
+
+        template<typename V>
+        inline Column<V> batch_column(const std::string& name, size_t batch, std::vector<V>& copy) const {
+            /** View a column in one record batch, or convert it into copy */
+            const Field& info = this->field(name);
+            const Chunk& chunk = info.chunks.at(batch);
+            if (stored_as<V>(info) && !chunk.null_count && (uintptr_t)chunk.values % alignof(V) == 0)
+                return Column<V>((const V*)chunk.values, chunk.length);
+
+            if constexpr (std::is_floating_point<V>::value) {
+                copy = this->numeric_column<V>(name, batch);
+                return Column<V>(copy);
+            }
+            else {
+                return this->column<V>(name, batch); // Throws, explaining why
+            }
+        }
+
+        MappedFile file;
+        std::vector<std::string> names;
+        std::vector<Field> fields;
+        std::map<int64_t, std::vector<std::string>> dictionaries;
+        std::vector<size_t> batch_rows;
+        size_t rows = 0;
+    };
+
 }
\ No newline at end of file
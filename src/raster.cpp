@@ -0,0 +1,248 @@
+# include "flexplot.h"
+# include <cmath>
+# include <sstream>
+
+// Software rasterization and PNG encoding for dense data layers
+
+namespace SVG {
+    namespace {
+        inline float clamp01(float x) {
+            return x < 0 ? 0 : (x > 1 ? 1 : x);
+        }
+
+        inline int hex_digit(char c) {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        }
+
+        bool pixel_range(float lo, float hi, size_t size, long& first, long& last) {
+            /** Clip [lo, hi] to the pixels [0, size) in floating point, so
+             *  the casts can't overflow. Returns false if nothing is left.
+             */
+            lo = std::max(floor(lo), 0.0f);
+            hi = std::min(ceil(hi), (float)size - 1);
+            if (!(lo <= hi)) return false;
+
+            first = (long)lo;
+            last = (long)hi;
+            return true;
+        }
+
+        bool clip_segment(double& x0, double& y0, double& x1, double& y1,
+            double x_min, double x_max, double y_min, double y_max) {
+            /** Clip a segment to a rectangle (Liang-Barsky), returning false
+             *  if it misses it. Ends moved onto a side are set to that side
+             *  exactly, since x0 + t * dx loses far away ends' precision.
+             */
+            const double dx = x1 - x0, dy = y1 - y0;
+            const double p[4] = { -dx, dx, -dy, dy },
+                q[4] = { x0 - x_min, x_max - x0, y0 - y_min, y_max - y0 },
+                sides[4] = { x_min, x_max, y_min, y_max };
+
+            double t0 = 0, t1 = 1;
+            int side0 = -1, side1 = -1;
+            for (int i = 0; i < 4; i++) {
+                if (p[i] == 0) {
+                    if (q[i] < 0) return false; // Parallel to and outside this side
+                    continue;
+                }
+
+                const double t = q[i] / p[i];
+                if (p[i] < 0 && t > t0) {
+                    t0 = t;
+                    side0 = i;
+                }
+                else if (p[i] > 0 && t < t1) {
+                    t1 = t;
+                    side1 = i;
+                }
+            }
+
+            if (t0 > t1) return false;
+
+            const double start_x = x0, start_y = y0;
+            if (side0 >= 0) {
+                x0 = side0 < 2 ? sides[side0] : start_x + t0 * dx;
+                y0 = side0 < 2 ? start_y + t0 * dy : sides[side0];
+            }
+            if (side1 >= 0) {
+                x1 = side1 < 2 ? sides[side1] : start_x + t1 * dx;
+                y1 = side1 < 2 ? start_y + t1 * dy : sides[side1];
+            }
+            return true;
+        }
+
+        void write_chunk(std::string& png, const char* type, const std::string& data) {
+            /** Append a PNG chunk: length, type, data, CRC of type + data */
+            unsigned int len = (unsigned int)data.size();
+            for (int shift = 24; shift >= 0; shift -= 8)
+                png.push_back((char)((len >> shift) & 0xff));
+
+            size_t start = png.size();
+            png.append(type, 4);
+            png.append(data);
+
+            unsigned int crc = crc32(png.data() + start, png.size() - start);
+            for (int shift = 24; shift >= 0; shift -= 8)
+                png.push_back((char)((crc >> shift) & 0xff));
+        }
+    }
+
+    std::string base64(const std::string& data) {
+        static const char digits[] =
+            "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+        std::string ret;
+        ret.reserve(4 * ((data.size() + 2) / 3));
+
+        size_t i = 0;
+        for (; i + 2 < data.size(); i += 3) {
+            unsigned int n = ((unsigned char)data[i] << 16) |
+                ((unsigned char)data[i + 1] << 8) | (unsigned char)data[i + 2];
+            ret.push_back(digits[(n >> 18) & 63]);
+            ret.push_back(digits[(n >> 12) & 63]);
+            ret.push_back(digits[(n >> 6) & 63]);
+            ret.push_back(digits[n & 63]);
+        }
+
+        if (i < data.size()) {
+            unsigned int n = (unsigned char)data[i] << 16;
+            if (i + 1 < data.size()) n |= (unsigned char)data[i + 1] << 8;
+
+            ret.push_back(digits[(n >> 18) & 63]);
+            ret.push_back(digits[(n >> 12) & 63]);
+            ret.push_back(i + 1 < data.size() ? digits[(n >> 6) & 63] : '=');
+            ret.push_back('=');
+        }
+
+        return ret;
+    }
+
+    Raster::Color Raster::parse_color(const std::string& color, float opacity) {
+        /** Parse a "#rgb" or "#rrggbb" colour, falling back to black */
+        Color ret = { 0, 0, 0, clamp01(opacity) };
+        if (color.empty() || color[0] != '#')
+            return ret;
+
+        int channels[3];
+        size_t digits = color.size() - 1;
+        for (size_t i = 0; i < 3; i++) {
+            if (digits == 6)
+                channels[i] = hex_digit(color[1 + 2 * i]) * 16 + hex_digit(color[2 + 2 * i]);
+            else if (digits == 3)
+                channels[i] = hex_digit(color[1 + i]) * 17;
+            else
+                return ret;
+
+            if (channels[i] < 0)
+                return ret;
+        }
+
+        ret.r = channels[0] / 255.0f;
+        ret.g = channels[1] / 255.0f;
+        ret.b = channels[2] / 255.0f;
+        return ret;
+    }
+
+    void Raster::fill_circle(float cx, float cy, float r, const Color& color) {
+        /** Coverage falls off linearly over the one pixel wide band
+         *  straddling the circle's edge
+         */
+        if (!(r > 0) || !std::isfinite(cx) || !std::isfinite(cy) || !std::isfinite(r)) return;
+
+        long x_lo, x_hi, y_lo, y_hi;
+        if (!pixel_range(cx - r - 1, cx + r + 1, width, x_lo, x_hi) ||
+            !pixel_range(cy - r - 1, cy + r + 1, height, y_lo, y_hi))
+            return;
+
+        for (long y = y_lo; y <= y_hi; y++) {
+            float dy = (float)y + 0.5f - cy;
+            for (long x = x_lo; x <= x_hi; x++) {
+                float dx = (float)x + 0.5f - cx;
+                float coverage = clamp01(r + 0.5f - sqrt(dx * dx + dy * dy));
+                if (coverage > 0)
+                    this->blend((size_t)x, (size_t)y, color, coverage);
+            }
+        }
+    }
+
+    void Raster::draw_line(float x0, float y0, float x1, float y1, float line_width,
+        const Color& color) {
+        /** Same edge falloff as fill_circle(), using each pixel's distance
+         *  to the segment
+         */
+        if (!std::isfinite(x0) || !std::isfinite(y0) || !std::isfinite(x1) || !std::isfinite(y1))
+            return;
+
+        float half = std::max(line_width, 1.0f) / 2;
+        if (!std::isfinite(half)) return;
+
+        // Parts further than a line width off the canvas can't cover any
+        // pixel. Dropping them keeps the math below small enough for floats,
+        // even for far away ends, and is done in double so it can't overflow.
+        double ax = x0, ay = y0, bx = x1, by = y1;
+        const double margin = (double)half + 1;
+        if (!clip_segment(ax, ay, bx, by, -margin, width + margin, -margin, height + margin))
+            return;
+
+        long x_lo, x_hi, y_lo, y_hi;
+        if (!pixel_range((float)(std::min(ax, bx) - margin), (float)(std::max(ax, bx) + margin), width, x_lo, x_hi) ||
+            !pixel_range((float)(std::min(ay, by) - margin), (float)(std::max(ay, by) + margin), height, y_lo, y_hi))
+            return;
+
+        const double dx = bx - ax, dy = by - ay, len_sq = dx * dx + dy * dy;
+
+        for (long y = y_lo; y <= y_hi; y++) {
+            for (long x = x_lo; x <= x_hi; x++) {
+                double px = x + 0.5 - ax, py = y + 0.5 - ay;
+                double t = len_sq > 0 ? std::min(std::max((px * dx + py * dy) / len_sq, 0.0), 1.0) : 0;
+                double ex = px - t * dx, ey = py - t * dy;
+                float coverage = clamp01((float)(half + 0.5 - sqrt(ex * ex + ey * ey)));
+                if (coverage > 0)
+                    this->blend((size_t)x, (size_t)y, color, coverage);
+            }
+        }
+    }
+
+    std::string Raster::to_png() const {
+        /** Encode as an 8-bit RGBA PNG, un-premultiplying each pixel */
+        std::string header;
+        for (size_t dim : { width, height })
+            for (int shift = 24; shift >= 0; shift -= 8)
+                header.push_back((char)((dim >> shift) & 0xff));
+        header += std::string("\x08\x06\x00\x00\x00", 5); // RGBA, 8 bits per channel
+
+        std::ostringstream idat;
+        {
+            Deflater deflater(idat, 6, Deflater::ZLIB);
+            std::string row(1 + 4 * width, '\0'); // Filter type 0 (none)
+
+            for (size_t y = 0; y < height; y++) {
+                const float* p = &pixels[4 * y * width];
+                for (size_t x = 0; x < width; x++, p += 4) {
+                    float a = p[3];
+                    char* out = &row[1 + 4 * x];
+                    for (int c = 0; c < 3; c++)
+                        out[c] = (char)(a > 0 ? (int)(clamp01(p[c] / a) * 255 + 0.5f) : 0);
+                    out[3] = (char)(int)(clamp01(a) * 255 + 0.5f);
+                }
+
+                deflater.write(row.data(), row.size());
+            }
+
+            deflater.finish();
+        }
+
+        std::string png("\x89PNG\r\n\x1a\n", 8);
+        write_chunk(png, "IHDR", header);
+        write_chunk(png, "IDAT", idat.str());
+        write_chunk(png, "IEND", "");
+        return png;
+    }
+
+    std::string Raster::to_data_uri() const {
+        return "data:image/png;base64," + base64(this->to_png());
+    }
+}
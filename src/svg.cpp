@@ -1,5 +1,9 @@
 #define PI 3.14159265
 #include "flexplot.h"
+#include <array>
+#include <mutex>
+#include <set>
+#include <typeinfo>
 // #include "str.h"
 
 using std::deque;
@@ -7,6 +11,304 @@ using std::vector;
 using std::string;
 
 namespace SVG {
+    namespace Attr {
+        /** Registry of attribute names not known at compile time */
+        struct Registry {
+            Registry() {
+                for (AttrKey i = 0; i < NUM_BUILTIN; i++) {
+                    names.push_back(builtin_names[i]);
+                    keys[names.back()] = i;
+                }
+            }
+
+            // Must be in the same order as the enum in flexplot.h. Kept apart
+            // from names, which intern() may grow while these are read.
+            const std::array<std::string, NUM_BUILTIN> builtin_names = {
+                "x", "y", "x1", "x2", "y1", "y2", "cx", "cy", "r", "width",
+                "height", "d", "xmlns", "fill", "fill-opacity", "stroke",
+                "stroke-width", "stroke-opacity", "stroke-dasharray", "style",
+                "transform", "text-anchor", "dominant-baseline", "font-family",
+                "font-size", "class", "href", "preserveAspectRatio"
+            };
+
+            std::mutex lock;
+            std::unordered_map<std::string, AttrKey> keys;
+            std::deque<std::string> names; /*< deque so references stay valid */
+        };
+
+        static Registry& registry() {
+            static Registry reg;
+            return reg;
+        }
+
+        AttrKey intern(const std::string& name) {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> guard(reg.lock);
+            auto it = reg.keys.find(name);
+            if (it != reg.keys.end())
+                return it->second;
+
+            AttrKey key = (AttrKey)reg.names.size();
+            reg.names.push_back(name);
+            reg.keys[name] = key;
+            return key;
+        }
+
+        const std::string& name(AttrKey key) {
+            Registry& reg = registry();
+            if (key < NUM_BUILTIN) // Never modified after construction
+                return reg.builtin_names[key];
+
+            std::lock_guard<std::mutex> guard(reg.lock);
+            return reg.names[key];
+        }
+    }
+
+    template<typename F>
+    static char* format_floating(char* first, char* last, F number,
+        const NumberFormat& format) {
+        /** Write a number into [first, last) and return the end of the output
+         *  Output does not depend on the current locale
+         */
+        std::to_chars_result result;
+        if (format.mode == NumberFormat::SHORTEST)
+            result = std::to_chars(first, last, number);
+        else
+            result = std::to_chars(first, last, number, std::chars_format::fixed,
+                std::min(std::max(format.precision, 0), 16));
+
+        if (result.ec != std::errc())
+            return first;
+
+        char* end = result.ptr;
+        if (format.mode == NumberFormat::FIXED && format.trim_zeros
+            && std::find(first, end, '.') != end) {
+            while (*(end - 1) == '0') end--;
+            if (*(end - 1) == '.') end--;
+        }
+
+        // Don't write negative zero
+        if (end - first == 2 && first[0] == '-' && first[1] == '0') {
+            first[0] = '0';
+            end = first + 1;
+        }
+
+        return end;
+    }
+
+    char* format_number(char* first, char* last, float number,
+        const NumberFormat& format) {
+        return format_floating(first, last, number, format);
+    }
+
+    char* format_number(char* first, char* last, double number,
+        const NumberFormat& format) {
+        return format_floating(first, last, number, format);
+    }
+
+    std::string format_number(float number, const NumberFormat& format) {
+        char temp[64];
+        return std::string(temp, format_number(temp, temp + sizeof(temp), number, format));
+    }
+
+    std::string format_number(double number, const NumberFormat& format) {
+        char temp[512]; // Fixed notation of large doubles is long
+        return std::string(temp, format_number(temp, temp + sizeof(temp), number, format));
+    }
+
+    NodePool::~NodePool() {
+        // Destroy every node, then release the blocks they live in
+        for (Block* block = head; block;) {
+            for (size_t offset = 0; offset < block->used;) {
+                Header* header = (Header*)(data(block) + offset);
+                if (header->node)
+                    header->node->~Element();
+                offset += header->stride;
+            }
+
+            Block* next = block->next;
+            ::operator delete(block);
+            block = next;
+        }
+    }
+
+    void* NodePool::allocate(size_t size) {
+        auto slots = free_slots.find(size);
+        if (slots != free_slots.end() && !slots->second.empty()) {
+            void* ret = slots->second.back();
+            slots->second.pop_back();
+            return ret;
+        }
+
+        if (!head || head->capacity - head->used < size) {
+            // Blocks grow geometrically so small trees stay small
+            size_t capacity = std::max(size, next_block);
+            next_block = std::min(next_block * 2, (size_t)MAX_BLOCK);
+
+            Block* block = (Block*)::operator new(round_up(sizeof(Block)) + capacity);
+            block->next = head;
+            block->capacity = capacity;
+            block->used = 0;
+
+            head = block;
+            if (!tail) tail = block;
+        }
+
+        void* ret = data(head) + head->used;
+        head->used += size;
+        return ret;
+    }
+
+    void NodePool::release(Element* node) {
+        /** Destroy a node and its children, keeping their memory for reuse */
+        for (auto child : node->children)
+            this->release(child);
+
+        Header* header = (Header*)((char*)node - round_up(sizeof(Header)));
+        node->~Element();
+        header->node = nullptr;
+        free_slots[header->stride].push_back(header);
+    }
+
+    void NodePool::absorb(std::unique_ptr<NodePool> other) {
+        /** Take ownership of all nodes in another pool
+         *  Nodes which still refer to the other pool are forwarded here
+         */
+        if (other->head) {
+            if (tail)
+                tail->next = other->head;
+            else
+                head = other->head;
+
+            tail = other->tail;
+            other->head = other->tail = nullptr;
+        }
+
+        for (auto& slots : other->free_slots) {
+            auto& mine = this->free_slots[slots.first];
+            mine.insert(mine.end(), slots.second.begin(), slots.second.end());
+        }
+        other->free_slots.clear();
+
+        other->forward = this;
+        this->absorbed.push_back(std::move(other));
+    }
+
+    NodePool& NodePool::resolve() {
+        /** Return the pool which currently owns this pool's nodes */
+        if (!forward)
+            return *this;
+
+        forward = &forward->resolve();
+        return *forward;
+    }
+
+    Element::Element(const Element& other) :
+        attr(other.attr), content(other.content), tag(other.tag) {
+        /** Deep copy an element and its children */
+        for (auto it = other.children.begin(); it != other.children.end(); ++it)
+            this->children.push_back((*it)->clone(this->get_pool()));
+    }
+
+    Element::Element(Element&& other) :
+        attr(std::move(other.attr)),
+        content(std::move(other.content)),
+        children(std::move(other.children)),
+        tag(std::move(other.tag)),
+        owned_pool(std::move(other.owned_pool)),
+        pool(other.pool) {
+        other.children.clear();
+        other.pool = nullptr;
+    }
+
+    Element& Element::operator=(const Element& other) {
+        if (this != &other) {
+            Element temp(other);
+            *this = std::move(temp);
+        }
+
+        return *this;
+    }
+
+    Element& Element::operator=(Element&& other) {
+        if (this != &other) {
+            attr = std::move(other.attr);
+            content = std::move(other.content);
+            children = std::move(other.children);
+            tag = std::move(other.tag);
+            owned_pool = std::move(other.owned_pool);
+            pool = other.pool;
+
+            other.children.clear();
+            other.pool = nullptr;
+        }
+
+        return *this;
+    }
+
+    void Element::append_children(Element&& other) {
+        /** Move another tree's children to the end of this element's,
+         *  taking over the pool they were allocated in. other must be the
+         *  root of its tree (i.e. not itself a child of some element).
+         */
+        if (other.owned_pool)
+            this->get_pool().absorb(std::move(other.owned_pool));
+
+        this->children.insert(this->children.end(),
+            other.children.begin(), other.children.end());
+        other.children.clear();
+        other.pool = nullptr;
+    }
+
+    float Attributes::get_float(AttrKey key) const {
+        /** Return a numeric attribute, or NAN if it isn't set */
+        const Entry* entry = find(key);
+        if (!entry)
+            return NAN;
+
+        switch (entry->type) {
+        case FLOAT:
+            return entry->number;
+        case INT:
+            return (float)entry->integer;
+        default:
+            return strtof(strings[entry->index].c_str(), nullptr);
+        }
+    }
+
+    std::string Attributes::get_string(AttrKey key) const {
+        /** Return an attribute formatted as text, or an empty string */
+        const Entry* entry = find(key);
+        if (!entry)
+            return "";
+
+        switch (entry->type) {
+        case FLOAT:
+            return format_number(entry->number);
+        case INT:
+            return std::to_string(entry->integer);
+        default:
+            return strings[entry->index];
+        }
+    }
+
+    void Attributes::write(Writer& out) const {
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            out << ' ' << Attr::name(it->key) << "=\"";
+            switch (it->type) {
+            case FLOAT:
+                out << it->number;
+                break;
+            case INT:
+                out << it->integer;
+                break;
+            default:
+                out << strings[it->index];
+            }
+            out << '"';
+        }
+    }
+
     float Line::get_slope() {
         return (y2() - y1()) / (x2() - x1());
     }
@@ -55,32 +357,371 @@ namespace SVG {
         return std::make_pair(x_pos, y_pos);
     }
 
-# define to_string_attrib for (auto it = attr.begin(); it != attr.end(); ++it) \
-    ret += " " + it->first + "=" + "\"" + it->second += "\""
-
-    std::string Element::to_string() {
-        std::string ret = "<" + tag;
+    void Element::write(Writer& out) {
+        /** Serialize this element and its children in a single pass */
+        out << '<' << tag;
 
         // Set attributes
-        to_string_attrib;
-        
+        this->attr.write(out);
+
         if (!this->children.empty()) {
-            ret += ">\n";
+            out << ">\n";
 
-            // Recursively get strings for child elements
-            for (auto it = children.begin(); it != children.end(); ++it)
-                ret += "\t" + (*it)->to_string() + "\n";
+            // Recursively write child elements
+            for (auto it = children.begin(); it != children.end(); ++it) {
+                out << '\t';
+                (*it)->write(out);
+                out << '\n';
+            }
 
-            return ret += "</" + tag + ">";
+            out << "</" << tag << '>';
+            return;
         }
 
-        return ret += " />";
+        out << " />";
     }
 
-    std::string Text::to_string() {
-        std::string ret = "<text";
-        to_string_attrib;
-        return ret += ">" + this->content + "</text>";
+    void Path::write(Writer& out) {
+        if (this->points.empty()) {
+            Element::write(out);
+            return;
+        }
+
+        out << "<path";
+        this->attr.write(out);
+
+        // Format the path data in one pass over the coordinate buffer
+        out << " d=\"M " << points[0] << ' ' << points[1];
+        for (size_t i = 2; i + 1 < points.size(); i += 2)
+            out << " L " << points[i] << ' ' << points[i + 1];
+        out << "\" />";
+    }
+
+    void CirclePath::write(Writer& out) {
+        /** Draw each circle as two half-circle arcs starting from its
+         *  leftmost point
+         */
+        out << "<path";
+        this->attr.write(out);
+        out << " d=\"";
+
+        for (size_t i = 0; i + 2 < circles.size(); i += 3) {
+            const float cx = circles[i], cy = circles[i + 1], r = circles[i + 2];
+            out << 'M' << cx - r << ' ' << cy
+                << 'a' << r << ' ' << r << " 0 1 0 " << 2 * r << " 0"
+                << 'a' << r << ' ' << r << " 0 1 0 " << -2 * r << " 0";
+        }
+
+        out << "\" />";
+    }
+
+    void Stream::write(Writer& out) {
+        if (this->tag.empty()) {
+            this->generate(out);
+            return;
+        }
+
+        out << '<' << tag;
+        this->attr.write(out);
+        out << ">\n";
+        this->generate(out);
+        out << "</" << tag << '>';
+    }
+
+    void Style::write(Writer& out) {
+        out << "<style";
+        this->attr.write(out);
+        out << '>' << this->content << "</style>";
+    }
+
+    namespace {
+        /** Presentation attributes which have an equivalent CSS property */
+        const AttrKey PRESENTATION_ATTRS[] = {
+            Attr::FILL, Attr::FILL_OPACITY, Attr::STROKE, Attr::STROKE_WIDTH,
+            Attr::STROKE_OPACITY, Attr::STROKE_DASHARRAY, Attr::TEXT_ANCHOR,
+            Attr::DOMINANT_BASELINE, Attr::FONT_FAMILY, Attr::FONT_SIZE
+        };
+
+        inline std::string trim(const std::string& str) {
+            size_t begin = str.find_first_not_of(" \t\n");
+            if (begin == std::string::npos)
+                return "";
+            return str.substr(begin, str.find_last_not_of(" \t\n") - begin + 1);
+        }
+
+        std::string css_declarations(const Attributes& attr) {
+            /** Return the presentation attributes and inline style of an
+             *  element as a canonical list of CSS declarations
+             */
+            std::map<std::string, std::string> properties;
+            for (auto key : PRESENTATION_ATTRS) {
+                const Attributes::Entry* entry = attr.find(key);
+                if (!entry)
+                    continue;
+
+                std::string value = attr.get_string(key);
+                if (key == Attr::FONT_SIZE && entry->type != Attributes::STRING)
+                    value += "px"; // CSS font sizes need units
+                properties[Attr::name(key)] = value;
+            }
+
+            // Inline styles take precedence over presentation attributes
+            std::string style = attr.get_string(Attr::STYLE);
+            for (size_t begin = 0; begin < style.size();) {
+                size_t end = style.find(';', begin);
+                if (end == std::string::npos)
+                    end = style.size();
+
+                std::string declaration = style.substr(begin, end - begin);
+                size_t colon = declaration.find(':');
+                if (colon != std::string::npos)
+                    properties[trim(declaration.substr(0, colon))] =
+                    trim(declaration.substr(colon + 1));
+                begin = end + 1;
+            }
+
+            std::string ret;
+            for (auto it = properties.begin(); it != properties.end(); ++it) {
+                if (!ret.empty()) ret += ';';
+                ret += it->first + ':' + it->second;
+            }
+
+            return ret;
+        }
+    }
+
+    void Element::hoist_styles(size_t min_uses) {
+        /** Find elements in this tree with identical presentation attributes,
+         *  move those attributes into CSS classes defined in a <style>
+         *  element, and replace them with class references
+         *
+         *  Only attribute sets used at least min_uses times, and for which
+         *  this makes the output smaller, are hoisted. Rules are scoped
+         *  under this element's id, which is derived from the tree's
+         *  content if missing, and only apply to its descendants.
+         */
+        std::vector<std::pair<Element*, std::string>> styled;
+        std::unordered_map<std::string, size_t> uses;
+        std::vector<std::string> order; // Assign class names in document order
+        std::set<std::string> taken;    // Class names already in use
+
+        std::vector<Element*> stack(this->children.rbegin(), this->children.rend());
+        while (!stack.empty()) {
+            Element* node = stack.back();
+            stack.pop_back();
+            for (auto it = node->children.rbegin(); it != node->children.rend(); ++it)
+                stack.push_back(*it);
+
+            std::string names = node->attr.get_string(Attr::CLASS);
+            for (size_t begin = 0, end; begin < names.size(); begin = end + 1) {
+                end = std::min(names.find(' ', begin), names.size());
+                taken.insert(names.substr(begin, end - begin));
+            }
+
+            std::string css = css_declarations(node->attr);
+            if (css.empty())
+                continue;
+
+            if (uses[css]++ == 0)
+                order.push_back(css);
+            styled.push_back(std::make_pair(node, std::move(css)));
+        }
+
+        if (styled.empty())
+            return;
+
+        // Style rules apply to the whole page an SVG is inlined into, so
+        // scope them under this tree's id. Without one, the id is a
+        // checksum of the tree, so output doesn't depend on other trees.
+        const AttrKey id = Attr::intern("id");
+        std::string root_id = this->attr.get_string(id);
+        const bool new_id = root_id.empty();
+        if (new_id) {
+            const std::string content = this->to_string();
+            const unsigned int checksum = crc32(content.data(), content.size());
+            root_id = "flexplot-";
+            for (int shift = 28; shift >= 0; shift -= 4)
+                root_id += "0123456789abcdef"[(checksum >> shift) & 15];
+        }
+        const std::string scope = "#" + root_id + " .";
+
+        // Pick which declaration sets are worth turning into classes
+        std::unordered_map<std::string, std::string> classes;
+        std::string rules;
+        size_t next_class = 0;
+        for (auto it = order.begin(); it != order.end(); ++it) {
+            const size_t count = uses[*it];
+            std::string name;
+            do {
+                name = "s" + std::to_string(next_class);
+            } while (taken.count(name) && ++next_class);
+
+            std::string rule = scope + name + "{" + *it + "}";
+            if (count < min_uses || count * it->size() <= rule.size() + count * (name.size() + 9))
+                continue;
+
+            classes[*it] = name;
+            rules += rule;
+            next_class++;
+        }
+
+        if (classes.empty())
+            return;
+        if (new_id)
+            this->attr.set(id, root_id);
+
+        for (auto it = styled.begin(); it != styled.end(); ++it) {
+            auto cls = classes.find(it->second);
+            if (cls == classes.end())
+                continue;
+
+            Attributes& attr = it->first->attr;
+            for (auto key : PRESENTATION_ATTRS)
+                attr.erase(key);
+            attr.erase(Attr::STYLE);
+
+            std::string names = attr.get_string(Attr::CLASS);
+            attr.set(Attr::CLASS, names.empty() ? cls->second : names + " " + cls->second);
+        }
+
+        this->children.insert(this->children.begin(),
+            this->get_pool().make<Style>(rules));
+    }
+
+    std::string Element::to_string() {
+        Writer out;
+        this->write(out);
+        return out.str();
+    }
+
+    namespace {
+        inline bool uses_element_write(const Element& node) {
+            /** Whether node is serialized by Element::write(), and so may
+             *  be split into its tags and children. Subclasses with their
+             *  own write() are always serialized as a unit.
+             */
+            return typeid(node) == typeid(Element) || typeid(node) == typeid(SVG)
+                || typeid(node) == typeid(Group);
+        }
+
+        size_t estimate_cost(Element* node) {
+            /** Rough estimate of how many bytes a subtree serializes to */
+            size_t cost = 16 + 16 * node->attr.size() + node->content.size();
+            if (dynamic_cast<Stream*>(node))
+                return (size_t)1 << 30; // Unknown, so make sure it is split out
+            else if (auto path = dynamic_cast<Path*>(node))
+                cost += 12 * path->size();
+            else if (auto circles = dynamic_cast<CirclePath*>(node))
+                cost += 48 * circles->size();
+
+            for (auto child : node->children)
+                cost += estimate_cost(child);
+            return cost;
+        }
+    }
+
+    void Element::split(std::vector<Piece>& pieces, size_t min_cost, const NumberFormat& format) {
+        /** Break this subtree into an ordered list of literal markup and
+         *  subtrees costing less than min_cost. Concatenating the pieces'
+         *  output gives exactly what write() would produce.
+         */
+        size_t cost = estimate_cost(this);
+        if (this->children.empty() || cost < min_cost || !uses_element_write(*this)) {
+            Piece piece;
+            piece.node = this;
+            piece.cost = cost;
+            pieces.push_back(std::move(piece));
+            return;
+        }
+
+        auto literal = [&pieces](const std::string& text) {
+            if (pieces.empty() || pieces.back().node)
+                pieces.emplace_back();
+            pieces.back().literal += text;
+        };
+
+        Writer open(format);
+        open << '<' << tag;
+        this->attr.write(open);
+        open << ">\n";
+        literal(open.str());
+
+        for (auto child : children) {
+            literal("\t");
+            child->split(pieces, min_cost, format);
+            literal("\n");
+        }
+
+        literal("</" + tag + ">");
+    }
+
+    void Element::write_parallel(Writer& out, size_t min_cost) {
+        /** Serialize large subtrees into separate buffers on worker threads,
+         *  then join them in document order. The output is byte-identical
+         *  to write(), which is used directly for trees costing less than
+         *  min_cost. Streams are written straight to out between the
+         *  buffered runs, so their output is never held in memory.
+         */
+        std::vector<Piece> pieces;
+        this->split(pieces, std::max(min_cost, (size_t)1), out.format);
+
+        size_t total = 0;
+        for (auto& piece : pieces)
+            total += piece.cost;
+
+        if (pieces.size() == 1 || Graphs::parallel_chunks(total, std::max(min_cost, (size_t)1)) == 1) {
+            this->write(out);
+            return;
+        }
+
+        auto write_run = [&](size_t first, size_t last) {
+            size_t cost = 0;
+            for (size_t i = first; i < last; i++)
+                cost += pieces[i].cost;
+
+            const size_t chunks = Graphs::parallel_chunks(cost, std::max(min_cost, (size_t)1));
+
+            // Assign contiguous runs of pieces to chunks of roughly equal cost
+            std::vector<size_t> bounds(chunks + 1, last);
+            bounds[0] = first;
+            for (size_t i = first, chunk = 1, sum = 0; i < last && chunk < chunks; i++) {
+                if (sum >= cost * chunk / chunks)
+                    bounds[chunk++] = i;
+                sum += pieces[i].cost;
+            }
+
+            std::vector<Writer> buffers(chunks, Writer(out.format));
+            Graphs::parallel_for(chunks, chunks, [&](size_t begin, size_t end, size_t) {
+                for (size_t chunk = begin; chunk < end; chunk++) {
+                    for (size_t i = bounds[chunk]; i < bounds[chunk + 1]; i++) {
+                        if (pieces[i].node)
+                            pieces[i].node->write(buffers[chunk]);
+                        else
+                            buffers[chunk] << pieces[i].literal;
+                    }
+                }
+            });
+
+            for (auto& buffer : buffers)
+                out << buffer.str();
+        };
+
+        size_t first = 0;
+        for (size_t i = 0; i < pieces.size(); i++) {
+            if (dynamic_cast<Stream*>(pieces[i].node)) {
+                write_run(first, i);
+                pieces[i].node->write(out);
+                first = i + 1;
+            }
+        }
+
+        write_run(first, pieces.size());
+    }
+
+    void Text::write(Writer& out) {
+        out << "<text";
+        this->attr.write(out);
+        out << '>' << this->content << "</text>";
     }
 }
 
@@ -88,10 +729,31 @@ namespace Graphs {
     void PlotBase::to_svg(const std::string filename) {
         /** plot an SVG */
         std::ofstream svg_file(filename, std::ios_base::binary);
-        svg_file << this->root.to_string();
+        this->to_svg(svg_file);
+        svg_file.close();
+    }
+
+    void PlotBase::to_svg(std::ostream& out) {
+        /** Stream the SVG document to an output stream */
+        SVG::Writer writer(out, this->number_format);
+        this->root.write_parallel(writer, this->parallel_threshold);
+        writer.flush();
+    }
+
+    void PlotBase::to_svgz(const std::string filename, int level) {
+        /** Write a gzip-compressed SVG (SVGZ) */
+        std::ofstream svg_file(filename, std::ios_base::binary);
+        this->to_svgz(svg_file, level);
         svg_file.close();
     }
 
+    void PlotBase::to_svgz(std::ostream& out, int level) {
+        /** Compress the SVG document as it is serialized */
+        SVG::DeflateStream compressed(out, level);
+        this->to_svg(compressed);
+        compressed.finish();
+    }
+
     float Legend::get_height() {
         return this->fills.size() * 30;
     }
@@ -115,8 +777,8 @@ namespace Graphs {
             label = SVG::Text(30, 15, this->labels[i]);
             label.set_attr("dominant-baseline", "central");
 
-            label_container.add_child(guide, label);
-            this->root.add_child(label_container);
+            label_container.add_child(std::move(guide), std::move(label));
+            this->root.add_child(std::move(label_container));
             y += 30;
         }
     }
@@ -170,9 +832,9 @@ namespace Graphs {
             .set_attr("stroke-dasharray", "10, 5");
 
         for (float i = 0; i <= lines; i++)
-            grid.add_child(SVG::Circle(polar.center(), polar.radius * i / lines));
+            grid.emplace_child<SVG::Circle>(polar.center(), polar.radius * i / lines);
 
-        root.add_child(grid);
+        root.add_child(std::move(grid));
     }
 
     void RadarChart::make_axes(DatasetCollection<CategoricalData>& data) {
@@ -200,7 +862,7 @@ namespace Graphs {
             line = Axis(polar.center().first, coord.first,
                 polar.center().second, coord.second);
             line.set_attr("stroke-width", 1).set_attr("stroke", "black");
-            this->axes.push_back((Axis*)root.add_child(line));
+            this->axes.push_back(root.add_child(std::move(line)));
 
             // Add text labels -- skip origin
             for (size_t j = 1; j <= this->grid_lines; j++) {
@@ -210,7 +872,7 @@ namespace Graphs {
                     label.set_attr("text-anchor", "start");
                 else
                     label.set_attr("text-anchor", "end");
-                axis_labels.add_child(label);
+                axis_labels.add_child(std::move(label));
             }
 
             // Add category label
@@ -221,14 +883,14 @@ namespace Graphs {
             else
                 label.set_attr("text-anchor", "start");
 
-            category_labels.add_child(label);
-            this->root.add_child(axis_labels);
+            category_labels.add_child(std::move(label));
+            this->root.add_child(std::move(axis_labels));
         }
 
-        this->root.add_child(category_labels);
+        this->root.add_child(std::move(category_labels));
     }
 
-    void RadarChart::plot(DatasetCollection<CategoricalData> data) {
+    void RadarChart::plot(DatasetCollection<CategoricalData>& data) {
         /** Plot each of the percentages on an axis on the radar chart */
         std::vector<std::string> fill_colors = data.get_fill(),
             stroke_colors = data.get_stroke();
@@ -245,8 +907,9 @@ namespace Graphs {
         // Add lines connecting end of each axis
         for (auto it = data.datasets.begin(); it != data.datasets.end(); ++it) {
             SVG::Path data_line;
+            data_line.reserve(data.size() + 1);
             for (size_t i = 0; i < data.size(); i++) {
-                coord = axes[i]->map(it->y_values.at(i));
+                coord = axes[i]->map((*it)->y_values.at(i));
                 data_line.line_to(coord.first, coord.second);
             }
 
@@ -256,7 +919,7 @@ namespace Graphs {
                 .set_attr("fill", *fill_color)
                 .set_attr("fill-opacity", 0.3);
 
-            root.add_child(data_line);
+            root.add_child(std::move(data_line));
             ++fill_color;
             ++stroke_color;
         }
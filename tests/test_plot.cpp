@@ -1,6 +1,10 @@
 # define CATCH_CONFIG_MAIN
 # include "catch.hpp"
 # include "flexplot.h"
+# include <chrono>
+# include <cstring>
+# include <functional>
+# include <set>
 
 using namespace Graphs;
 
@@ -219,4 +223,1348 @@ TEST_CASE("Radar Chart Test - 3 Categories", "[test_radar2]") {
     plot.plot(dataset);
     plot.make_legend(dataset);
     plot.to_svg("test_radar.svg");
-}
\ No newline at end of file
+}
+
+TEST_CASE("Stream Output Test", "[test_stream]") {
+    NumericData points = {
+        std::vector<long double>({ 1, 2, 3, 4, 5 }),
+        std::vector<long double>({ 1, 2, 3, 4, 5 }),
+    };
+
+    Graph<NumericData> plot;
+    plot.plot(points);
+    plot.make_point(points);
+
+    std::ostringstream out;
+    plot.to_svg(out);
+    std::string svg = out.str();
+
+    REQUIRE(svg.substr(0, 4) == "<svg");
+    REQUIRE(svg.substr(svg.size() - 6) == "</svg>");
+    REQUIRE(std::count(svg.begin(), svg.end(), '\n') > 5);
+}
+
+TEST_CASE("Attribute Storage Test", "[test_attr]") {
+    SVG::Line line(1, 2, 3, 4);
+    REQUIRE(line.x1() == 1);
+    REQUIRE(line.y2() == 4);
+
+    line.set_attr("x1", 10).set_attr("stroke", "#000000")
+        .set_attr("my-attribute", 0.5);
+    REQUIRE(line.x1() == 10);
+    REQUIRE(line.attr.size() == 6);
+    REQUIRE(line.attr.get_float(SVG::Attr::intern("my-attribute")) == 0.5);
+    REQUIRE(isnan(line.attr.get_float(SVG::Attr::FILL)));
+    REQUIRE(line.to_string() == "<line x1=\"10\" x2=\"2\" y1=\"3\" "
+        "y2=\"4\" stroke=\"#000000\" my-attribute=\"0.5\" />");
+
+    SECTION("Names are read while others are interned") {
+        std::thread writer([]() {
+            for (int i = 0; i < 2000; i++)
+                SVG::Attr::intern("data-concurrent-" + std::to_string(i));
+        });
+
+        bool same = true;
+        for (int i = 0; i < 2000; i++)
+            same &= SVG::Attr::name(SVG::Attr::STROKE) == "stroke";
+        writer.join();
+
+        REQUIRE(same);
+        REQUIRE(SVG::Attr::name(SVG::Attr::intern("data-concurrent-1999")) == "data-concurrent-1999");
+    }
+}
+
+TEST_CASE("Element Tree Test", "[test_tree]") {
+    SVG::SVG root;
+    SVG::Group group;
+    SVG::Element* label = group.add_child(SVG::Text(0, 0, "Label"));
+    for (int i = 0; i < 1000; i++)
+        group.emplace_child<SVG::Circle>(i, i, 2);
+
+    // Copies are deep and keep the type of each child
+    SVG::Group copy = group;
+    copy.children[0]->content = "Copy";
+    REQUIRE(group.to_string().find(">Label</text>") != std::string::npos);
+    REQUIRE(copy.to_string().find(">Copy</text>") != std::string::npos);
+
+    // Pointers into a subtree stay valid after it is attached
+    SVG::Group* attached = root.add_child(std::move(group));
+    label->content = "Moved";
+    REQUIRE(group.children.empty());
+    REQUIRE(attached->children[0] == label);
+    REQUIRE(root.children[0]->children.size() == 1001);
+    REQUIRE(root.to_string().find(">Moved</text>") != std::string::npos);
+}
+
+TEST_CASE("Path Test", "[test_path]") {
+    SVG::Path path;
+    path.reserve(3);
+    path.line_to(1, 2);
+    path.line_to(3, 4);
+    path.to_origin();
+    path.set_attr("fill", "none");
+
+    REQUIRE(path.size() == 3);
+    REQUIRE(path.to_string() == "<path fill=\"none\" d=\"M 1 2 L 3 4 L 1 2\" />");
+}
+
+
+TEST_CASE("Number Format Test", "[test_number_format]") {
+    SVG::NumberFormat fixed;
+    REQUIRE(SVG::format_number(480.000031f, fixed) == "480");
+    REQUIRE(SVG::format_number(1.005f, fixed) == "1");
+    REQUIRE(SVG::format_number(-0.001f, fixed) == "0");
+    REQUIRE(SVG::format_number(12.5f, fixed) == "12.5");
+
+    fixed.precision = 3;
+    fixed.trim_zeros = false;
+    REQUIRE(SVG::format_number(2.5f, fixed) == "2.500");
+
+    SVG::NumberFormat shortest;
+    shortest.mode = SVG::NumberFormat::SHORTEST;
+    REQUIRE(SVG::format_number(0.1f, shortest) == "0.1");
+    REQUIRE(std::stof(SVG::format_number(480.000031f, shortest)) == 480.000031f);
+
+    REQUIRE(Graphs::to_string(5) == "5.0");
+    REQUIRE(Graphs::to_string(2.25, 3) == "2.250");
+
+    SECTION("Axis labels follow the plot's format") {
+        NumericData points = { std::vector<double>({ 1, 2 }), std::vector<double>({ 3, 4 }) };
+        Graph<NumericData> plot;
+        plot.number_format.trim_zeros = false;
+        plot.number_format.precision = 1;
+        plot.plot(points);
+
+        std::ostringstream out;
+        plot.to_svg(out);
+        REQUIRE(out.str().find("transform=\"translate(75.0,315.0) rotate(75)\"") != std::string::npos);
+    }
+}
+
+TEST_CASE("SVGZ Output Test", "[test_svgz]") {
+    std::vector<long double> x, y;
+    for (int i = 0; i < 1000; i++) {
+        x.push_back(i);
+        y.push_back((i * 37) % 101);
+    }
+
+    NumericData points(x, y);
+    Graph<NumericData> plot;
+    plot.plot(points);
+    plot.make_point(points);
+    plot.to_svgz("test_scatter.svgz");
+
+    std::ostringstream plain, compressed;
+    plot.to_svg(plain);
+    plot.to_svgz(compressed);
+
+    std::string gz = compressed.str();
+    REQUIRE(gz.size() > 18);
+    REQUIRE((unsigned char)gz[0] == 0x1f);
+    REQUIRE((unsigned char)gz[1] == 0x8b);
+    REQUIRE(gz.size() < plain.str().size() / 3);
+
+    // Trailer holds the uncompressed size
+    size_t isize = 0;
+    for (int i = 0; i < 4; i++)
+        isize |= (size_t)(unsigned char)gz[gz.size() - 4 + i] << (8 * i);
+    REQUIRE(isize == plain.str().size());
+}
+
+TEST_CASE("SVGZ Benchmark", "[.benchmark]") {
+    std::vector<long double> x, y;
+    for (int i = 0; i < 200000; i++) {
+        x.push_back(i % 1000);
+        y.push_back((i * 7919) % 1009);
+    }
+
+    NumericData points(x, y);
+    Graph<NumericData> plot;
+    plot.plot(points);
+    plot.make_point(points);
+
+    auto time = [](std::function<void()> func) {
+        auto start = std::chrono::steady_clock::now();
+        func();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    std::ostringstream plain;
+    double plain_time = time([&]() { plot.to_svg(plain); });
+    size_t plain_size = plain.str().size();
+    std::cout << "svg: " << plain_size << " bytes, "
+        << plain_size / plain_time / 1e6 << " MB/s" << std::endl;
+
+    for (int level : { 1, 6, 9 }) {
+        std::ostringstream compressed;
+        double svgz_time = time([&]() { plot.to_svgz(compressed, level); });
+        std::cout << "svgz (level " << level << "): " << compressed.str().size()
+            << " bytes, " << plain_size / svgz_time / 1e6 << " MB/s" << std::endl;
+    }
+}
+
+TEST_CASE("Style Hoisting Test", "[test_hoist_styles]") {
+    SVG::SVG root;
+    for (int i = 0; i < 10; i++) {
+        SVG::Text label(0, (float)i, "Label");
+        label.set_attr("text-anchor", "end")
+            .set_attr("style", "font-family: sans-serif; font-size: 12px;");
+        root.add_child(std::move(label));
+    }
+
+    SVG::Circle unique(0, 0, 1);
+    unique.set_attr("fill", "red");
+    root.add_child(std::move(unique));
+
+    root.hoist_styles();
+    std::string svg = root.to_string();
+    const SVG::AttrKey id = SVG::Attr::intern("id");
+    const std::string root_id = root.attr.get_string(id);
+    REQUIRE(root_id.find("flexplot") == 0);
+    REQUIRE(svg.find("<style>#" + root_id + " .s0{font-family:sans-serif;font-size:12px;text-anchor:end}</style>")
+        != std::string::npos);
+    REQUIRE(svg.find("style=") == std::string::npos);
+    REQUIRE(svg.find("class=\"s0\"") != std::string::npos);
+    REQUIRE(svg.find("fill=\"red\"") != std::string::npos); // Used once, so left alone
+
+    // Hoisting again must not reuse class names
+    for (int i = 0; i < 10; i++)
+        root.emplace_child<SVG::Text>(0, 0, "More")->set_attr("text-anchor", "start");
+    root.hoist_styles();
+    REQUIRE(root.attr.get_string(id) == root_id);
+    REQUIRE(root.to_string().find("#" + root_id + " .s1{text-anchor:start}") != std::string::npos);
+
+    SECTION("Rules of two documents on one page don't clash") {
+        SVG::SVG other;
+        for (int i = 0; i < 10; i++)
+            other.emplace_child<SVG::Text>(0, 0, "Other")->set_attr("text-anchor", "start");
+        other.hoist_styles();
+
+        const std::string other_id = other.attr.get_string(id);
+        REQUIRE(other_id != root_id);
+        REQUIRE(other.to_string().find("<style>#" + other_id + " .s0{text-anchor:start}")
+            != std::string::npos);
+    }
+
+    SECTION("Ids don't depend on other documents") {
+        auto make = []() {
+            SVG::SVG doc;
+            for (int i = 0; i < 10; i++)
+                doc.emplace_child<SVG::Text>(0, 0, "Same")->set_attr("text-anchor", "middle");
+            doc.hoist_styles();
+            return doc.attr.get_string(SVG::Attr::intern("id"));
+        };
+
+        const std::string first = make();
+        root.hoist_styles();
+        REQUIRE(make() == first);
+        REQUIRE(first != root_id);
+    }
+
+    SECTION("Attributes of the root are left alone") {
+        // Rules only match descendants of the element with the id
+        SVG::SVG styled;
+        styled.set_attr("fill", "blue").set_attr("stroke", "#000000");
+        for (int i = 0; i < 10; i++)
+            styled.emplace_child<SVG::Rect>(0, 0, 1, 1)->set_attr("fill", "blue")
+                .set_attr("stroke", "#000000");
+        styled.hoist_styles();
+        REQUIRE(styled.attr.get_string(SVG::Attr::FILL) == "blue");
+        REQUIRE(styled.children[1]->attr.get_string(SVG::Attr::FILL) == "");
+        REQUIRE(styled.children[1]->attr.get_string(SVG::Attr::CLASS) == "s0");
+    }
+
+    SECTION("Rules are scoped under an existing id") {
+        SVG::SVG named;
+        named.set_attr("id", "chart");
+        for (int i = 0; i < 10; i++)
+            named.emplace_child<SVG::Text>(0, 0, "Named")->set_attr("text-anchor", "end");
+        named.hoist_styles();
+        REQUIRE(named.attr.get_string(id) == "chart");
+        REQUIRE(named.to_string().find("<style>#chart .s0{text-anchor:end}") != std::string::npos);
+    }
+}
+
+TEST_CASE("Batched Point Test", "[test_point_path]") {
+    NumericData points = {
+        std::vector<long double>({ 1, 2, 3, 4, 5 }),
+        std::vector<long double>({ 1, 2, 3, 4, 5 }),
+        std::vector<long double>({ 10, 20, 30, 40, 50 })
+    };
+
+    Graph<NumericData> plot;
+    plot.point_mode = PointMode::PATH;
+    plot.plot(points);
+
+    SVG::SVG* dots = plot.make_point(points);
+    REQUIRE(dots->children.size() == 1);
+    SVG::CirclePath* markers = dynamic_cast<SVG::CirclePath*>(dots->children[0]);
+    REQUIRE(markers);
+    REQUIRE(markers->size() == 5);
+
+    std::string path = dots->children[0]->to_string();
+    REQUIRE(path.find("M65 250a10 10 0 1 0 20 0a10 10 0 1 0 -20 0M") != std::string::npos);
+    plot.to_svg("test_bubble_path.svg");
+}
+
+TEST_CASE("Line Downsampling Test", "[test_line_downsampling]") {
+    // Noisy series with a single spike, far denser than the canvas
+    std::vector<long double> x, y;
+    for (size_t i = 0; i < 100000; i++) {
+        x.push_back((long double)i);
+        y.push_back((long double)((i * 7919) % 1000) + (i == 54321 ? 50000 : 0));
+    }
+
+    NumericData data = { x, y };
+    Graph<NumericData> plot;
+    plot.plot(data);
+    const size_t columns = (size_t)(DEFAULT_GRAPH.width -
+        DEFAULT_GRAPH.margin_left - DEFAULT_GRAPH.margin_right);
+
+    SECTION("M4 keeps every pixel column's extremes") {
+        plot.line_downsampling = Downsampling::M4;
+        SVG::Path* line = dynamic_cast<SVG::Path*>(plot.make_line(data));
+        REQUIRE(line);
+        REQUIRE(line->size() <= 4 * (columns + 1));
+
+        Polyline full;
+        for (size_t i = 0; i < x.size(); i++)
+            full.push_back(std::make_pair((float)i / 10, (float)y[i]));
+        Polyline reduced = downsample_m4(full);
+
+        std::map<float, std::pair<float, float>> full_range, reduced_range;
+        auto track = [](std::map<float, std::pair<float, float>>& ranges, std::pair<float, float> p) {
+            auto it = ranges.emplace(floor(p.first), std::make_pair(p.second, p.second)).first;
+            it->second.first = std::min(it->second.first, p.second);
+            it->second.second = std::max(it->second.second, p.second);
+        };
+
+        for (auto& p : full) track(full_range, p);
+        for (auto& p : reduced) track(reduced_range, p);
+
+        REQUIRE(reduced.size() <= 4 * full_range.size());
+        REQUIRE(full_range == reduced_range);
+        REQUIRE(reduced.front() == full.front());
+        REQUIRE(reduced.back() == full.back());
+    }
+
+    SECTION("LTTB keeps two vertices per pixel column and the spike") {
+        plot.line_downsampling = Downsampling::LTTB;
+        SVG::Path* line = dynamic_cast<SVG::Path*>(plot.make_line(data));
+        REQUIRE(line);
+        REQUIRE(line->size() == 2 * columns);
+
+        Polyline full;
+        for (size_t i = 0; i < x.size(); i++)
+            full.push_back(std::make_pair((float)i, (float)y[i]));
+        Polyline reduced = downsample_lttb(full, 500);
+
+        REQUIRE(reduced.size() == 500);
+        REQUIRE(reduced.front() == full.front());
+        REQUIRE(reduced.back() == full.back());
+        REQUIRE(std::find(reduced.begin(), reduced.end(), full[54321]) != reduced.end());
+    }
+}
+
+TEST_CASE("Binned Point Test", "[test_point_binned]") {
+    // Many more points than pixels piled up in one corner, plus a loner
+    std::vector<long double> x = { 100 }, y = { 100 };
+    for (size_t i = 0; i < 300000; i++) {
+        x.push_back((long double)(i % 1000) / 100);
+        y.push_back((long double)((i * 31) % 1000) / 100);
+    }
+
+    NumericData data = { x, y };
+    Graph<NumericData> plot;
+    plot.point_mode = PointMode::BINNED;
+    plot.plot(data);
+
+    SVG::SVG* bins = plot.make_point(data);
+    const size_t cells = (size_t)((DEFAULT_GRAPH.width - DEFAULT_GRAPH.margin_left
+        - DEFAULT_GRAPH.margin_right) / plot.bin_size + 1) *
+        (size_t)((DEFAULT_GRAPH.height - DEFAULT_GRAPH.margin_top
+        - DEFAULT_GRAPH.margin_bottom) / plot.bin_size + 1);
+
+    REQUIRE(!bins->children.empty());
+    REQUIRE(bins->children.size() <= cells);
+
+    // Densest cell is opaque, sparsest is the faintest level
+    float min_opacity = 1, max_opacity = 0;
+    for (auto& child : bins->children) {
+        float opacity = child->attr.get_float(SVG::Attr::FILL_OPACITY);
+        min_opacity = std::min(min_opacity, opacity);
+        max_opacity = std::max(max_opacity, opacity);
+    }
+
+    REQUIRE(max_opacity == 1);
+    REQUIRE(min_opacity == 1.0f / plot.bin_levels);
+    plot.to_svg("test_scatter_binned.svg");
+}
+
+TEST_CASE("Raster Layer Test", "[test_raster]") {
+    SECTION("Base64") {
+        REQUIRE(SVG::base64("Man") == "TWFu");
+        REQUIRE(SVG::base64("Ma") == "TWE=");
+        REQUIRE(SVG::base64("M") == "TQ==");
+    }
+
+    SECTION("Anti-aliased circle") {
+        SVG::Raster canvas(20, 20);
+        canvas.fill_circle(10, 10, 5, SVG::Raster::parse_color("#ff0000"));
+
+        REQUIRE(canvas.pixel(10, 10).a == 1);
+        REQUIRE(canvas.pixel(10, 10).r == 1);
+        REQUIRE(canvas.pixel(1, 1).a == 0);
+
+        // Edge pixels are partially covered
+        float edge = canvas.pixel(14, 10).a;
+        REQUIRE(edge > 0);
+        REQUIRE(edge < 1);
+    }
+
+    SECTION("Non-finite and far away shapes are skipped") {
+        SVG::Raster canvas(20, 20);
+        SVG::Raster::Color red = SVG::Raster::parse_color("#ff0000");
+        canvas.fill_circle(NAN, 10, 5, red);
+        canvas.fill_circle(10, INFINITY, 5, red);
+        canvas.fill_circle(1e30f, -1e30f, 5, red);
+        canvas.draw_line(0, 0, NAN, 10, 1, red);
+        canvas.draw_line(-INFINITY, 0, 10, 10, 1, red);
+        canvas.draw_line(-1e30f, 50, 1e30f, 50, 1, red); // Below the canvas
+        REQUIRE(canvas.pixel(10, 10).a == 0);
+
+        // Segments with far away but finite ends are clipped, not lost
+        canvas.draw_line(-1e30f, 10.5f, 1e30f, 10.5f, 1, red);
+        canvas.draw_line(3.5f, -3e38f, 3.5f, 3e38f, 1, red);
+        canvas.draw_line(-1e6f, -1e6f + 0.5f, 1e6f, 1e6f + 0.5f, 1, red); // The diagonal
+        REQUIRE(canvas.pixel(0, 10).a == 1);
+        REQUIRE(canvas.pixel(19, 10).a == 1);
+        REQUIRE(canvas.pixel(3, 0).a == 1);
+        REQUIRE(canvas.pixel(3, 19).a == 1);
+        REQUIRE(canvas.pixel(15, 15).a > 0.5);
+        REQUIRE(canvas.pixel(10, 5).a == 0);
+    }
+
+    SECTION("Dense scatter becomes an image") {
+        std::vector<long double> x, y;
+        for (size_t i = 0; i < 1000; i++) {
+            x.push_back((long double)i);
+            y.push_back((long double)((i * 37) % 100));
+        }
+
+        NumericData data = { x, y };
+        Graph<NumericData> plot;
+        plot.raster_threshold = 500;
+        plot.plot(data);
+
+        SVG::SVG* dots = plot.make_point(data);
+        REQUIRE(dots->children.size() == 1);
+        REQUIRE(dots->children[0]->attr.get_string(SVG::Attr::HREF)
+            .find("data:image/png;base64,iVBORw0KGgo") == 0);
+        REQUIRE(dots->children[0]->attr.get_float(SVG::Attr::WIDTH) ==
+            DEFAULT_GRAPH.width - DEFAULT_GRAPH.margin_left - DEFAULT_GRAPH.margin_right);
+
+        plot.make_line(data);
+        plot.to_svg("test_scatter_raster.svg");
+    }
+}
+
+TEST_CASE("Parallel Serialization Test", "[test_write_parallel]") {
+    // Several large sibling groups, like a MultiGraph's data_groups
+    SVG::SVG root;
+    for (int group = 0; group < 12; group++) {
+        SVG::Group* dots = root.emplace_child<SVG::Group>();
+        dots->set_attr("fill", QUALITATIVE_COLORS[group]);
+        for (int i = 0; i < 2000; i++)
+            dots->emplace_child<SVG::Circle>((float)i / 3, (float)(i * group % 400), 2.0f);
+
+        SVG::Path* line = root.emplace_child<SVG::Path>();
+        for (int i = 0; i < 500; i++)
+            line->line_to((float)i, (float)(i * group % 300) / 7);
+    }
+    root.emplace_child<SVG::Text>(10, 10, "Title");
+
+    const std::string serial = root.to_string();
+
+    // Split into several chunks even on a single core machine
+    max_threads = 4;
+
+    SECTION("Identical output when split") {
+        for (size_t min_cost : { 1, 64, 4096, 1 << 16 }) {
+            SVG::Writer out;
+            root.write_parallel(out, min_cost);
+            REQUIRE(out.str() == serial);
+        }
+    }
+
+    SECTION("Plot output is unaffected") {
+        std::vector<long double> x, y;
+        for (size_t i = 0; i < 20000; i++) {
+            x.push_back((long double)i);
+            y.push_back((long double)((i * 37) % 100));
+        }
+
+        NumericData data = { x, y };
+        Graph<NumericData> plot;
+        plot.plot(data);
+        plot.make_point(data);
+
+        std::ostringstream parallel, single;
+        plot.parallel_threshold = 1024;
+        plot.to_svg(parallel);
+        plot.parallel_threshold = (size_t)-1;
+        plot.to_svg(single);
+        REQUIRE(parallel.str() == single.str());
+    }
+
+    max_threads = 0;
+}
+
+TEST_CASE("Parallel Mark Test", "[test_parallel_marks]") {
+    std::vector<long double> x, y;
+    for (size_t i = 0; i < 5000; i++) {
+        x.push_back((long double)i);
+        y.push_back((long double)((i * 37) % 100));
+    }
+
+    NumericData data = { x, y };
+
+    // Same markup whether marks are generated on one thread or several
+    auto render = [&](size_t threads, PointMode mode) {
+        max_threads = threads;
+        Graph<NumericData> plot;
+        plot.point_mode = mode;
+        plot.point_chunk = 256;
+        plot.plot(data);
+
+        SVG::SVG* dots = plot.make_point(data);
+        if (mode == PointMode::PATH) {
+            SVG::CirclePath* markers = dynamic_cast<SVG::CirclePath*>(dots->children[0]);
+            REQUIRE(markers);
+            REQUIRE(markers->size() == data.size());
+        }
+        else
+            REQUIRE(dots->children.size() == data.size());
+
+        std::ostringstream out;
+        plot.to_svg(out);
+        max_threads = 0;
+        return out.str();
+    };
+
+    REQUIRE(render(4, PointMode::CIRCLES) == render(1, PointMode::CIRCLES));
+    REQUIRE(render(4, PointMode::PATH) == render(1, PointMode::PATH));
+}
+
+TEST_CASE("Batch Rendering Test", "[test_batch]") {
+    // Build a small plot from the shared defaults
+    auto make_plot = [](size_t i) {
+        NumericData data = {
+            std::vector<long double>({ 1, 2, 3, 4, 5 }),
+            std::vector<long double>({ 1, (long double)i, 3, 4, 5 })
+        };
+
+        Graph<NumericData> plot;
+        plot.plot(data);
+        plot.make_point(data, QUALITATIVE_COLORS[i % QUALITATIVE_COLORS.size()]);
+        return plot;
+    };
+
+    const size_t jobs = 24;
+    Graph<NumericData> shared_plot;
+    BatchRenderer::Stats stats;
+    {
+        BatchRenderer batch(4, 2);
+        for (size_t i = 0; i < jobs; i++)
+            batch.submit("test_batch_" + std::to_string(i) + ".svg", [i, &make_plot]() {
+                return make_plot(i);
+            });
+
+        // Pointers to plots work too
+        batch.submit("test_batch_ptr.svg", []() {
+            return std::unique_ptr<PlotBase>(new Graph<NumericData>());
+        });
+        batch.submit("test_batch_shared.svg", []() {
+            return std::make_shared<Graph<NumericData>>();
+        });
+        batch.submit("test_batch_raw.svg", [&shared_plot]() {
+            return &shared_plot;
+        });
+
+        stats = batch.finish();
+        REQUIRE_THROWS(batch.submit("test_batch_late.svg", [i = 0, &make_plot]() {
+            return make_plot(i);
+        }));
+    }
+
+    REQUIRE(stats.jobs == jobs + 3);
+    REQUIRE(stats.failed == 0);
+    REQUIRE(stats.latency.size() == jobs + 3);
+    REQUIRE(stats.throughput() > 0);
+
+    // Same output as rendering each plot on this thread
+    for (size_t i = 0; i < jobs; i++) {
+        std::ifstream file("test_batch_" + std::to_string(i) + ".svg", std::ios_base::binary);
+        std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        std::ostringstream expected;
+        make_plot(i).to_svg(expected);
+        REQUIRE(contents == expected.str());
+    }
+}
+
+TEST_CASE("Plot Ownership Test", "[test_batch]") {
+    // Copies would share nodes with the original, so only moves are allowed
+    REQUIRE(!std::is_copy_constructible<Graph<NumericData>>::value);
+    REQUIRE(!std::is_copy_assignable<Graph<NumericData>>::value);
+
+    NumericData data = {
+        std::vector<long double>({ 1, 2, 3 }),
+        std::vector<long double>({ 4, 5, 6 })
+    };
+
+    std::unique_ptr<Graph<NumericData>> original(new Graph<NumericData>());
+    original->plot(data);
+    original->set_title("Original");
+
+    Graph<NumericData> moved(std::move(*original));
+    original.reset();
+    moved.set_title("Moved");
+
+    std::ostringstream out;
+    moved.to_svg(out);
+    REQUIRE(out.str().find("Moved") != std::string::npos);
+    REQUIRE(out.str().find("Original") == std::string::npos);
+}
+
+// Exposes the axes so tests can tell whether they were regenerated
+class LiveGraph : public Graph<NumericData> {
+public:
+    SVG::Group* axis() { return this->x_axis_group; }
+    SVG::Element* layer(size_t i) { return this->live_marks[i].layer; }
+};
+
+TEST_CASE("Incremental Append Test", "[test_append]") {
+    NumericData series = {
+        std::vector<long double>({ 0, 1, 2, 3 }),
+        std::vector<long double>({ 5, 7, 6, 8 })
+    };
+
+    LiveGraph live;
+    live.plot(series);
+    SVG::Path* line = dynamic_cast<SVG::Path*>(live.make_line(series));
+    REQUIRE(line);
+    SVG::SVG* dots = live.make_point(series);
+    SVG::Group* axis = live.axis();
+
+    // Inside the current axes: layers grow in place, axes are kept
+    live.append(series, { 1.5, 2.5 }, { 6.5, 7.5 });
+    REQUIRE(series.size() == 6);
+    REQUIRE(live.axis() == axis);
+    REQUIRE(line->size() == 6);
+    REQUIRE(dots->children.size() == 6);
+
+    // Past the right edge: axes are rebuilt with headroom
+    live.append(series, { 10 }, { 9 });
+    REQUIRE(live.axis() != axis);
+    axis = live.axis();
+
+    // Layers returned before are detached, but still safe to use
+    REQUIRE(live.layer(1) != dots);
+    REQUIRE(dots->children.empty());
+    dots->set_attr("opacity", 0.5);
+
+    std::ostringstream out;
+    live.to_svg(out);
+    REQUIRE(out.str().find(">12.5<") != std::string::npos); // 10 plus a quarter of the span
+
+    // ...so the next sample fits without another rebuild
+    live.append(series, { 11 }, { 8 });
+    REQUIRE(live.axis() == axis);
+    SVG::Path* redrawn = dynamic_cast<SVG::Path*>(live.layer(0));
+    REQUIRE(redrawn);
+    REQUIRE(redrawn->size() == 8);
+    REQUIRE(live.layer(1)->children.size() == 8);
+
+    // Every point stays inside the drawing area
+    for (auto& dot : live.layer(1)->children) {
+        REQUIRE(dot->attr.get_float(SVG::Attr::CX) >= DEFAULT_GRAPH.margin_left);
+        REQUIRE(dot->attr.get_float(SVG::Attr::CX) <= DEFAULT_GRAPH.width - DEFAULT_GRAPH.margin_right);
+        REQUIRE(dot->attr.get_float(SVG::Attr::CY) >= DEFAULT_GRAPH.margin_top);
+        REQUIRE(dot->attr.get_float(SVG::Attr::CY) <= DEFAULT_GRAPH.height - DEFAULT_GRAPH.margin_bottom);
+    }
+
+    live.to_svg("test_append.svg");
+
+    // Rebuilt axes reuse the memory of the ones they replace
+    LiveGraph lines;
+    lines.plot(series);
+    lines.make_line(series);
+
+    std::set<SVG::Group*> axes;
+    for (double x = 20; x < 1e6; x *= 2) {
+        lines.append(series, { x }, { 8 });
+        axes.insert(lines.axis());
+    }
+    REQUIRE(axes.size() <= 4); // Out of 16 rebuilds
+
+    REQUIRE_THROWS(live.append(series, { 50 }, { 8 }, { 2 })); // series has no z values
+}
+
+TEST_CASE("Append Time Test", "[test_append]") {
+    // Appending one point at a time should take linear time
+    NumericData series = {
+        std::vector<long double>({ 0, 1 }),
+        std::vector<long double>({ 0, 1 })
+    };
+
+    LiveGraph live;
+    live.plot(series);
+    live.make_line(series);
+
+    auto append = [&](size_t n) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < n; i++) {
+            double x = (double)(series.size() % 2);
+            live.append(series, { x }, { x });
+        }
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    const double first = append(2500);
+    append(5000);
+    const double last = append(2500);
+
+    REQUIRE(series.size() == 10002);
+    SVG::Path* redrawn = dynamic_cast<SVG::Path*>(live.layer(0));
+    REQUIRE(redrawn);
+    REQUIRE(redrawn->size() == 10002);
+    REQUIRE(last < 4 * first); // Quadratic growth would make this about 7 times slower
+}
+
+TEST_CASE("Dataset Statistics Test", "[test_stats]") {
+    NumericData data = {
+        std::vector<long double>({ 3, NAN, -2, 8 }),
+        std::vector<long double>({ 1, 2, 3, 4 })
+    };
+
+    ColumnStats x = data.x_stats();
+    REQUIRE(x.min == -2);
+    REQUIRE(x.max == 8);
+    REQUIRE(x.sum == 9);
+    REQUIRE(x.count == 3);
+    REQUIRE(x.nan_count == 1);
+    REQUIRE(x.mean() == 3);
+
+    SECTION("Appended values are merged in") {
+        data.x_values.push_back(20);
+        data.y_values.push_back(-5);
+        REQUIRE(data.x_max() == 20);
+        REQUIRE(data.y_min() == -5);
+        REQUIRE(data.y_stats().count == 5);
+    }
+
+    SECTION("Replaced values are rescanned") {
+        REQUIRE(data.y_max() == 4);
+        data.y_values = { 100, 200, 300 };
+        REQUIRE(data.y_max() == 300);
+        REQUIRE(data.y_min() == 0);
+
+        data.y_values = std::vector<double>(100, -1);
+        REQUIRE(data.y_min() == -1);
+        REQUIRE(data.y_max() == -1);
+    }
+
+    SECTION("In-place changes need invalidate()") {
+        REQUIRE(data.y_max() == 4);
+        data.y_values[0] = 100;
+        REQUIRE(data.y_max() == 4); // Still cached
+        data.invalidate();
+        REQUIRE(data.y_max() == 100);
+    }
+
+    SECTION("Statistics are shared between threads") {
+        NumericData large = { std::vector<long double>(1 << 16, 1), std::vector<long double>(1 << 16, 2) };
+        large.y_values[777] = 9;
+
+        std::vector<long double> seen(8);
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < seen.size(); i++)
+            threads.emplace_back([&large, &seen, i]() { seen[i] = large.y_max(); });
+        for (auto& thread : threads)
+            thread.join();
+
+        REQUIRE(seen == std::vector<long double>(8, 9));
+    }
+
+    SECTION("Copies scan their own values") {
+        REQUIRE(data.y_max() == 4);
+        NumericData copy = data;
+        copy.y_values[0] = 100;
+        REQUIRE(copy.y_max() == 100);
+        REQUIRE(data.y_max() == 4);
+    }
+
+    SECTION("Empty datasets") {
+        NumericData empty;
+        REQUIRE(empty.y_min() == 0);
+        REQUIRE(empty.x_stats().count == 0);
+    }
+
+    SECTION("Large columns are split across threads") {
+        std::vector<long double> values(1 << 21);
+        for (size_t i = 0; i < values.size(); i++)
+            values[i] = (long double)(i % 1000) - 500;
+        values[12345] = NAN;
+
+        max_threads = 4;
+        ColumnStats stats = column_stats(values.data(), values.size());
+        max_threads = 0;
+
+        REQUIRE(stats.min == -500);
+        REQUIRE(stats.max == 499);
+        REQUIRE(stats.count == values.size() - 1);
+        REQUIRE(stats.nan_count == 1);
+    }
+
+    SECTION("Collections combine their datasets") {
+        NumericData other = {
+            std::vector<long double>({ -10, 0 }),
+            std::vector<long double>({ 0, 50 })
+        };
+
+        auto both = data + other;
+        REQUIRE(both.x_min() == -10);
+        REQUIRE(both.x_max() == 8);
+        REQUIRE(both.y_max() == 50);
+    }
+}
+
+TEST_CASE("Bulk Coordinate Mapping Test", "[test_bulk_map]") {
+    std::vector<long double> x, y;
+    for (size_t i = 0; i < 200000; i++) {
+        x.push_back((long double)i * 0.37L - 1000);
+        y.push_back((long double)((i * 7919) % 1000) / 3);
+    }
+    y[100] = NAN;
+
+    NumericData data = { x, y };
+    CartesianCoordinates<NumericData> rect(DEFAULT_GRAPH, data);
+
+    std::vector<float> xs(x.size()), ys(y.size());
+    max_threads = 4;
+    auto extent = rect.map(x.data(), y.data(), x.size(), xs.data(), ys.data());
+    max_threads = 0;
+
+    // Matches mapping one point at a time
+    for (size_t i = 0; i < x.size(); i += 997) {
+        REQUIRE(xs[i] == rect.map_x(x[i]));
+        if (i != 100) REQUIRE(ys[i] == rect.map_y(y[i]));
+    }
+
+    REQUIRE(std::isnan(ys[100]));
+    REQUIRE(extent.x_min == Approx(rect.x1));
+    REQUIRE(extent.x_max == Approx(rect.x2));
+    REQUIRE(extent.y_max == Approx(rect.y2));
+    REQUIRE(extent.y_min >= rect.y1);
+}
+
+TEST_CASE("Value Precision Test", "[test_precision]") {
+    std::vector<float> x = { 1, 2, 3, 4 }, y = { 2, 4, -1, 3 };
+    BasicNumericData<float> single = { x, y };
+    NumericData converted = { x, y };
+
+    REQUIRE(sizeof(single.y_values[0]) == sizeof(float));
+    REQUIRE(single.y_min() == -1);
+    REQUIRE(single.x_max() == converted.x_max());
+
+    // Small integers are exact in either type, so the plots are identical
+    Graph<BasicNumericData<float>> plot;
+    plot.plot(single);
+    plot.make_point(single);
+
+    Graph<NumericData> reference;
+    reference.plot(converted);
+    reference.make_point(converted);
+
+    std::ostringstream out, expected;
+    plot.to_svg(out);
+    reference.to_svg(expected);
+    REQUIRE(out.str() == expected.str());
+
+    plot.append(single, { 5 }, { 10 });
+    REQUIRE(single.y_max() == 10);
+
+    BasicCategoricalData<float> bars = { { "a", "b" }, { 1, 2 } };
+    Graph<BasicCategoricalData<float>> bar_plot;
+    bar_plot.plot(bars);
+    bar_plot.make_bar(bars);
+
+    std::ostringstream bar_out;
+    bar_plot.to_svg(bar_out);
+    REQUIRE(bar_out.str().find("<rect") != std::string::npos);
+}
+
+TEST_CASE("Dataset View Test", "[test_view]") {
+    // Columns are only made from vectors explicitly, and never from temporaries
+    static_assert(!std::is_convertible<const std::vector<double>&, Column<double>>::value,
+        "Columns must be made explicitly");
+    static_assert(!std::is_constructible<Column<double>, std::vector<double>>::value,
+        "Columns of temporaries would dangle");
+    static_assert(std::is_constructible<Column<double>, std::vector<double>&>::value,
+        "Columns of lvalues are allowed");
+
+    // Interleaved (x, y) records, viewed in place
+    std::vector<double> records;
+    for (size_t i = 0; i < 1000; i++) {
+        records.push_back((double)i / 10);
+        records.push_back(sin((double)i / 50) * 100);
+    }
+
+    NumericView<> view = {
+        Column<double>(records.data(), 1000, 2),
+        Column<double>(records.data() + 1, 1000, 2)
+    };
+    NumericData copy;
+    for (size_t i = 0; i < 1000; i++) {
+        copy.x_values.push_back(records[2 * i]);
+        copy.y_values.push_back(records[2 * i + 1]);
+    }
+
+    REQUIRE(view.size() == 1000);
+    REQUIRE(view.x_max() == copy.x_max());
+    REQUIRE(view.y_min() == copy.y_min());
+
+    SECTION("Same plot as a copy of the data") {
+        Graph<NumericView<>> plot;
+        plot.plot(view);
+        plot.make_point(view);
+        plot.make_line(view);
+
+        Graph<NumericData> reference;
+        reference.plot(copy);
+        reference.make_point(copy);
+        reference.make_line(copy);
+
+        std::ostringstream out, expected;
+        plot.to_svg(out);
+        reference.to_svg(expected);
+        REQUIRE(out.str() == expected.str());
+    }
+
+    SECTION("Multiple categorical views") {
+        std::vector<std::string> labels = { "A", "B", "C" };
+        std::vector<double> heights = { 1, 2, 3, 4, 5, 6 };
+        CategoricalView<> first = { Column<std::string>(labels), Column<double>(heights.data(), 3) },
+            second = { Column<std::string>(labels), Column<double>(heights.data() + 3, 3) };
+
+        auto both = first + second;
+        REQUIRE(both.y_max() == 6);
+        REQUIRE(both.x_labels() == labels);
+
+        MultiGraph<CategoricalView<>> plot;
+        plot.plot(both);
+        plot.make_bar(both);
+        plot.make_legend(both);
+
+        std::ostringstream out;
+        plot.to_svg(out);
+        REQUIRE(out.str().find("<rect") != std::string::npos);
+    }
+}
+
+TEST_CASE("Shared Collection Test", "[test_collection]") {
+    NumericData a = { std::vector<double>({ 1, 2 }), std::vector<double>({ 3, 4 }) },
+        b = { std::vector<double>({ 5, 6 }), std::vector<double>({ 7, 8 }) };
+
+    SECTION("Lvalues are borrowed") {
+        auto set = a + b + a;
+        REQUIRE(set.datasets.size() == 3);
+        REQUIRE(set.datasets[0].get() == &a);
+        REQUIRE(set.datasets[1].get() == &b);
+        REQUIRE(set.datasets[2].get() == &a);
+
+        // Copies of a collection share its datasets
+        auto copy = set;
+        REQUIRE(copy.datasets[1].get() == &b);
+    }
+
+    SECTION("Rvalues are moved in") {
+        const double* values = b.y_values.data();
+        auto set = a + std::move(b);
+        REQUIRE(set.datasets[1]->y_values.data() == values);
+        REQUIRE(set.datasets[1].use_count() == 1);
+        REQUIRE(set.y_max() == 8);
+    }
+}
+
+TEST_CASE("CSV Loader Test", "[test_csv]") {
+    {
+        std::ofstream csv("test_csv.csv", std::ios::binary);
+        csv << "x,\"the \"\"y\"\"\",label,size\r\n";
+        for (int i = 0; i < 500; i++) {
+            csv << i << "," << i * 0.5 << ",";
+            if (i % 7 == 0) csv << "\"multi\nline, " << i << "\"";
+            else csv << "row " << i;
+            csv << "," << (i % 3 ? std::to_string(i % 5) : "") << "\r\n";
+        }
+        csv << "500,250,last,1"; // No trailing newline
+    }
+
+    CSVFormat format;
+    format.chunk_size = 256;
+    max_threads = 4;
+    CSVReader reader("test_csv.csv", format);
+
+    REQUIRE(reader.col_names() == std::vector<std::string>({ "x", "the \"y\"", "label", "size" }));
+    REQUIRE(reader.size() == 501);
+
+    NumericData data = reader.numeric_data("x", "the \"y\"", "size");
+    auto labels = reader.text_column("label");
+    max_threads = 0;
+
+    REQUIRE(data.name == "the \"y\"");
+    REQUIRE(data.size() == 501);
+    for (size_t i = 0; i <= 500; i++) {
+        REQUIRE(data.x_values[i] == i);
+        REQUIRE(data.y_values[i] == i * 0.5);
+        if (i % 3 == 0 && i != 500) REQUIRE(std::isnan(data.z_values[i]));
+    }
+
+    REQUIRE(data.z_values[500] == 1);
+    REQUIRE(labels[7] == "multi\nline, 7");
+    REQUIRE(labels[8] == "row 8");
+    REQUIRE(labels[500] == "last");
+
+    // A column can be selected more than once
+    NumericData diagonal = reader.numeric_data("x", "x");
+    REQUIRE(diagonal.x_values == diagonal.y_values);
+    REQUIRE(diagonal.x_values[500] == 500);
+
+    REQUIRE_THROWS_AS(reader.numeric_columns({ "x", "z" }), const ColumnNotFoundError&);
+    REQUIRE_THROWS_AS(reader.categorical_data("name", "x"), const ColumnNotFoundError&);
+}
+
+TEST_CASE("CSV Quoting Test", "[test_csv]") {
+    // Quotes in the middle of a field are plain text, and quoted newlines
+    // land on chunk boundaries for some of the chunk sizes below
+    auto label = [](int i) {
+        switch (i % 3) {
+        case 0: return std::to_string(i) + "\" disk";
+        case 1: return "line\nbreak \"" + std::to_string(i) + "\"";
+        default: return std::string("plain");
+        }
+    };
+
+    {
+        std::ofstream csv("test_csv_quotes.csv", std::ios::binary);
+        csv << "x,label\n";
+        for (int i = 0; i < 60; i++) {
+            csv << i << ",";
+            if (i % 3 == 1) csv << "\"line\nbreak \"\"" << i << "\"\"\"";
+            else csv << label(i);
+            csv << "\n";
+        }
+        csv << "\n60,blank line above\n";
+    }
+
+    for (size_t chunk_size : { 5, 11, 17, 64, 1 << 20 }) {
+        CSVFormat format;
+        format.chunk_size = chunk_size;
+        max_threads = 4;
+        CSVReader reader("test_csv_quotes.csv", format);
+        auto x = reader.numeric_columns({ "x" })[0];
+        auto labels = reader.text_column("label");
+        max_threads = 0;
+
+        // The blank line is read as a row with no values
+        REQUIRE(reader.size() == 62);
+        for (int i = 0; i < 60; i++) {
+            REQUIRE(x[i] == i);
+            REQUIRE(labels[i] == label(i));
+        }
+
+        REQUIRE(std::isnan(x[60]));
+        REQUIRE(x[61] == 60);
+        REQUIRE(labels[61] == "blank line above");
+    }
+}
+
+TEST_CASE("Arrow Reader Test", "[test_arrow]") {
+    // Written by pyarrow: write_feather(table, compression="uncompressed", chunksize=3)
+    // x: float64 [1, 2, 3, 4, 5], n: int64 [10, 20, null, 40, 50],
+    // team: dictionary<int32, utf8> [a, b, a, c, b]
+    const char* hex =
+        "4152524f57310000ffffffff000100001000000000000a000c000600050008000a0000000001040004000000b0ffffff"
+        "0400000003000000ac0000006400000014000000100018000800060007000c0010001400100000000000010514000000"
+        "3c000000200000000400000000000000040000007465616d0000000008000800000004000800000004000000ccffffff"
+        "00000001200000000400040004000000ccffffff00000102100000001c0000000400000000000000010000006e000000"
+        "08000c0008000700080000000000000140000000100014000800060007000c0000001000100000000000010310000000"
+        "1800000004000000000000000100000078000600080006000600000000000200ffffffffa80000001400000000000000"
+        "0c0014000600050008000c000c0000000002040014000000180000000000000008000a00000004000800000010000000"
+        "00000a0018000c00040008000a0000004c00000010000000030000000000000000000000030000000000000000000000"
+        "000000000000000000000000000000001000000000000000100000000000000003000000000000000000000001000000"
+        "03000000000000000000000000000000000000000100000002000000030000006162630000000000ffffffffe8000000"
+        "14000000000000000c0016000600050008000c000c0000000003040018000000700000000000000000000a0018000c00"
+        "040008000a0000007c000000100000000300000000000000000000000600000000000000000000000000000000000000"
+        "000000000000000028000000000000002800000000000000010000000000000030000000000000002800000000000000"
+        "580000000000000000000000000000005800000000000000140000000000000000000000030000000300000000000000"
+        "00000000000000000300000000000000010000000000000003000000000000000000000000000000000000000000f03f"
+        "00000000000000400000000000000840000000000000104000000000000014401b000000000000000a00000000000000"
+        "140000000000000000000000000000002800000000000000320000000000000000000000010000000000000002000000"
+        "0100000000000000ffffffffe800000014000000000000000c0016000600050008000c000c0000000003040018000000"
+        "280000000000000000000a0018000c00040008000a0000007c0000001000000002000000000000000000000006000000"
+        "000000000000000000000000000000000000000000000000100000000000000010000000000000000000000000000000"
+        "100000000000000010000000000000002000000000000000000000000000000020000000000000000800000000000000"
+        "000000000300000002000000000000000000000000000000020000000000000000000000000000000200000000000000"
+        "000000000000000000000000000010400000000000001440280000000000000032000000000000000200000001000000"
+        "ffffffff00000000100000000c001400060008000c0010000c0000000000040064000000400000000400000002000000"
+        "d801000000000000f00000000000000070000000000000003803000000000000f0000000000000002800000000000000"
+        "00000000010000001001000000000000b000000000000000180000000000000000000000b0ffffff0400000003000000"
+        "ac0000006400000014000000100018000800060007000c00100014001000000000000105140000003c00000020000000"
+        "0400000000000000040000007465616d0000000008000800000004000800000004000000ccffffff0000000120000000"
+        "0400040004000000ccffffff00000102100000001c0000000400000000000000010000006e00000008000c0008000700"
+        "080000000000000140000000100014000800060007000c00000010001000000000000103100000001800000004000000"
+        "000000000100000078000600080006000600000000000200600100004152524f5731";
+
+    {
+        std::ofstream file("test_arrow.feather", std::ios::binary);
+        for (const char* p = hex; *p; p += 2)
+            file.put((char)std::stoi(std::string(p, 2), nullptr, 16));
+    }
+
+    ArrowReader reader("test_arrow.feather");
+    REQUIRE(reader.col_names() == std::vector<std::string>({ "x", "n", "team" }));
+    REQUIRE(reader.size() == 5);
+    REQUIRE(reader.batches() == 2);
+
+    SECTION("Columns are viewed in place") {
+        Column<double> x = reader.column<double>("x", 1);
+        REQUIRE(x.size() == 2);
+        REQUIRE(x[0] == 4);
+        REQUIRE(x[1] == 5);
+
+        NumericView<int64_t> view = reader.numeric_view<int64_t>("n", "n", "", 1);
+        REQUIRE(view.y_max() == 50);
+
+        REQUIRE_THROWS(reader.column<float>("x"));      // Wrong type
+        REQUIRE_THROWS(reader.column<int64_t>("n", 0)); // Has a null
+    }
+
+    SECTION("Lengths which overflow buffer size checks are rejected") {
+        std::string bytes;
+        for (const char* p = hex; *p; p += 2)
+            bytes += (char)std::stoi(std::string(p, 2), nullptr, 16);
+
+        // Patch the length of the second record batch and of its field nodes,
+        // so multiplying it by 32 or 64 bits wraps around to a few bytes
+        const uint64_t length = (1ull << 59) + 2;
+        for (size_t offset : { 896, 1016, 1032, 1048 })
+            std::memcpy(&bytes[offset], &length, sizeof(length));
+
+        {
+            std::ofstream file("test_arrow_malformed.feather", std::ios::binary);
+            file << bytes;
+        }
+        REQUIRE_THROWS_AS(ArrowReader("test_arrow_malformed.feather"), const std::runtime_error&);
+    }
+
+    SECTION("Columns are converted") {
+        std::vector<double> n = reader.numeric_column("n");
+        REQUIRE(n[1] == 20);
+        REQUIRE(std::isnan(n[2]));
+
+        CategoricalData teams = reader.categorical_data("team", "x");
+        REQUIRE(teams.x_values == std::vector<std::string>({ "a", "b", "a", "c", "b" }));
+        REQUIRE(teams.y_max() == 5);
+    }
+
+    SECTION("Record batches are read one at a time") {
+        ChunkedData<> chunked = reader.chunks("x", "n");
+        size_t batches = 0;
+        chunked.read([&](NumericView<>& batch) {
+            REQUIRE(batch.size() == (batches++ ? 2 : 3));
+        });
+        REQUIRE(batches == 2);
+        REQUIRE(chunked.size() == 5);
+        REQUIRE(chunked.x_max() == 5);
+        REQUIRE(chunked.y_max() == 50);
+
+        // Integer columns can only be viewed in place, and batch 0 has a null
+        ChunkedData<double, int64_t> by_count = reader.chunks<double, int64_t>("n", "x");
+        REQUIRE_THROWS(by_count.size());
+    }
+
+    SECTION("Columns of different types are viewed together") {
+        NumericView<double, int64_t> view = reader.numeric_view<double, int64_t>("n", "x", "", 1);
+        REQUIRE(&view.x_values[0] == &reader.column<int64_t>("n", 1)[0]);
+        REQUIRE(view.x_max() == 50);
+        REQUIRE(view.y_max() == 5);
+
+        Graph<NumericView<double, int64_t>> plot;
+        plot.plot(view);
+        plot.make_point(view);
+
+        NumericData copy = { std::vector<double>({ 40, 50 }), std::vector<double>({ 4, 5 }) };
+        Graph<NumericData> reference;
+        reference.plot(copy);
+        reference.make_point(copy);
+
+        std::ostringstream out, expected;
+        plot.to_svg(out);
+        reference.to_svg(expected);
+        REQUIRE(out.str() == expected.str());
+    }
+
+    SECTION("Columns of another type are copied per batch") {
+        ChunkedData<float> chunked = reader.chunks<float>("x", "n");
+        std::vector<float> x, n;
+        chunked.read([&](NumericView<float>& batch) {
+            for (size_t i = 0; i < batch.size(); i++) {
+                x.push_back(batch.x_values[i]);
+                n.push_back(batch.y_values[i]);
+            }
+        });
+
+        REQUIRE(x == std::vector<float>({ 1, 2, 3, 4, 5 }));
+        REQUIRE(n[1] == 20);
+        REQUIRE(std::isnan(n[2]));
+    }
+
+    REQUIRE_THROWS_AS(reader.numeric_data("x", "y"), const ColumnNotFoundError&);
+    REQUIRE_THROWS_AS(reader.chunks("x", "y"), const ColumnNotFoundError&);
+}
+
+TEST_CASE("Chunked Plotting Test", "[test_chunked]") {
+    NumericData copy;
+    for (size_t i = 0; i < 3000; i++) {
+        copy.x_values.push_back((double)i / 10);
+        copy.y_values.push_back(sin((double)i / 50) * 100);
+        copy.z_values.push_back(1 + (double)(i % 3));
+    }
+
+    // Generate the same 1000 point chunks each time the data is read
+    size_t reads = 0;
+    ChunkedData<> chunked([&](const ChunkedData<>::Visitor& visit) {
+        reads++;
+        for (size_t begin = 0; begin < copy.size(); begin += 1000) {
+            NumericView<> chunk = {
+                Column<double>(copy.x_values.data() + begin, 1000),
+                Column<double>(copy.y_values.data() + begin, 1000),
+                Column<double>(copy.z_values.data() + begin, 1000)
+            };
+            visit(chunk);
+        }
+    });
+
+    REQUIRE(chunked.size() == 3000);
+    REQUIRE(chunked.x_max() == copy.x_max());
+    REQUIRE(chunked.y_min() == copy.y_min());
+    REQUIRE(reads == 1);
+
+    auto same_plot = [&](size_t parallel_threshold) {
+        Graph<ChunkedData<>> plot;
+        plot.parallel_threshold = parallel_threshold;
+        plot.plot(chunked);
+        plot.stream_point(chunked);
+        plot.stream_line(chunked);
+
+        Graph<NumericData> reference;
+        reference.plot(copy);
+        reference.make_point(copy);
+        reference.make_line(copy);
+
+        std::ostringstream out, expected;
+        plot.to_svg(out);
+        reference.to_svg(expected);
+        REQUIRE(out.str() == expected.str());
+    };
+
+    SECTION("Same plot as the data in memory") {
+        same_plot(1 << 20);
+        REQUIRE(reads == 3);
+    }
+
+    SECTION("Same plot when written in parallel") {
+        max_threads = 4;
+        same_plot(1);
+        max_threads = 0;
+    }
+
+    SECTION("Rasterized") {
+        Graph<ChunkedData<>> plot;
+        plot.raster_threshold = 100;
+        plot.plot(chunked);
+        plot.stream_point(chunked);
+        plot.stream_line(chunked);
+
+        std::ostringstream out;
+        plot.to_svg(out);
+        REQUIRE(out.str().find("<circle") == std::string::npos);
+        REQUIRE(out.str().find("data:image/png;base64,") != std::string::npos);
+    }
+}
+
+TEST_CASE("Histogram Test", "[test_histogram]") {
+    std::vector<double> values = { 0, 1, 1.5, 2, 2, 3.5, 4, NAN, 9 };
+
+    SECTION("Equal-width bins") {
+        CategoricalData hist = histogram(values.data(), values.size(), 3);
+        REQUIRE(hist.x_values == std::vector<std::string>({ "[0, 3)", "[3, 6)", "[6, 9]" }));
+        REQUIRE(hist.y_values == std::vector<double>({ 5, 2, 1 }));
+    }
+
+    SECTION("Labels of large values keep their precision") {
+        std::vector<long double> edges = { 1e8, 1e8 + 0.5, 1e8 + 1 };
+        CategoricalData hist = histogram(edges, { 1, 2 });
+        REQUIRE(hist.x_values == std::vector<std::string>({
+            "[100000000, 100000000.5)", "[100000000.5, 100000001]" }));
+    }
+
+    SECTION("Explicit edges") {
+        // Values below the first or above the last edge aren't counted
+        std::vector<long double> edges = { 1, 2, 4 };
+        REQUIRE(bin_counts(values.data(), values.size(), edges) == std::vector<size_t>({ 2, 4 }));
+        REQUIRE(width_edges(0.5, 9, 2) == std::vector<long double>({ 0, 2, 4, 6, 8, 10 }));
+    }
+
+    SECTION("Binning rules") {
+        REQUIRE(bin_edges(values.data(), values.size(), Binning::STURGES).size() == 5);
+
+        std::vector<double> spread;
+        for (size_t i = 0; i < 1000; i++)
+            spread.push_back(sin((double)i) * 100);
+
+        // Freedman-Diaconis: the IQR of a sine wave is 100 * sqrt(2), so
+        // bins are 2 * 141 / cbrt(1000) = 28.3 wide, and 8 cover [-100, 100]
+        auto edges = bin_edges(spread.data(), spread.size(), Binning::FREEDMAN_DIACONIS);
+        REQUIRE(edges.size() == 9);
+
+        CategoricalData hist = histogram(spread.data(), spread.size(), edges);
+        double total = 0;
+        for (auto count : hist.y_values) total += count;
+        REQUIRE(total == 1000);
+    }
+
+    SECTION("Matches counting one value at a time") {
+        std::vector<float> many;
+        for (size_t i = 0; i < 3000000; i++)
+            many.push_back((float)sin((double)i * 0.37) * 50);
+
+        max_threads = 4;
+        std::vector<long double> uniform = bin_edges(many.data(), many.size(), (size_t)37),
+            uneven = { -50, -10, -9.5, 0, 0.25, 20, 49 };
+
+        for (auto& edges : { uniform, uneven }) {
+            std::vector<size_t> expected(edges.size() - 1, 0);
+            for (float value : many) {
+                if (value < edges.front() || value > edges.back()) continue;
+                size_t bin = std::upper_bound(edges.begin(), edges.end(), (long double)value) - edges.begin() - 1;
+                expected[std::min(bin, expected.size() - 1)]++;
+            }
+
+            REQUIRE(bin_counts(many.data(), many.size(), edges) == expected);
+        }
+        max_threads = 0;
+    }
+}